@@ -8,7 +8,17 @@
  */
 
 #include "engines/ack/ack.h"
+#include "engines/ack/benchmark.h"
+#include "engines/ack/blit.h"
+#include "engines/ack/cache.h"
+#include "engines/ack/console.h"
+#include "engines/ack/inputrec.h"
+#include "engines/ack/pack.h"
+#include "engines/ack/profiler.h"
+#include "engines/ack/saveindex.h"
+#include "engines/ack/snapshot.h"
 #include "engines/ack/detection.h"
+#include "engines/ack/text.h"
 #include "engines/ack/graphics.h"   // Adapted (if applicable) for ACK graphics management.
 #include "engines/ack/resource.h"   // Resource management for ACK.
 
@@ -25,6 +35,8 @@ namespace Ack {
 AckEngine::AckEngine(OSystem *syst, const AckGameDescription *gd)
 	: Engine(syst)
 	, _gameDescription(gd)
+	, _menuHitGrid(kScreenWidth, kScreenHeight)
+	, _mapView(kMapCols, kMapRows)
 {
 	// Set up debug channels.
 	DebugMan.addDebugChannel(kDebugGeneral, "general", "General debugging info");
@@ -33,6 +45,27 @@ AckEngine::AckEngine(OSystem *syst, const AckGameDescription *gd)
 	DebugMan.addDebugChannel(kDebugSound, "sound", "Sound operations");
 	DebugMan.addDebugChannel(kDebugScript, "script", "Script operations");
 
+	// Menu ticks per second; the menu loop sleeps for the rest of each tick.
+	ConfMan.registerDefault("tick_rate", 60);
+
+	// Memory budget of the resource cache, in kilobytes.
+	ConfMan.registerDefault("cache_budget", 2048);
+
+	// Iterations of the headless benchmark to run instead of the menu.
+	ConfMan.registerDefault("benchmark", 0);
+
+	// Input recording: save file names to record to or replay from, and
+	// whether a replay runs as fast as possible instead of at recorded pace.
+	ConfMan.registerDefault("record_input", "");
+	ConfMan.registerDefault("replay_input", "");
+	ConfMan.registerDefault("replay_fast", false);
+
+	// Quit once a replay at the recorded pace ends; fast replays always do.
+	ConfMan.registerDefault("replay_quit", false);
+
+	// Data pack searched ahead of the loose files, if present.
+	ConfMan.registerDefault("pack_file", "ACKDATA.ACK");
+
 	// Locate the game data directory from ScummVM configuration.
 	_systemDir = ConfMan.get("path");
 	if (!_systemDir.empty() && _systemDir.lastChar() != '/' && _systemDir.lastChar() != '\\')
@@ -42,6 +75,13 @@ AckEngine::AckEngine(OSystem *syst, const AckGameDescription *gd)
 
 	// Initialize resource manager object.
 	_resourceManager = new ResourceManager(this);
+	_textRenderer = new TextRenderer();
+	_profiler = new Profiler();
+	_inputRecorder = new InputRecorder();
+	_snapshots = new SnapshotStore(_targetName);
+	_pack = nullptr;
+	_cache = new ResourceCache(MAX(ConfMan.getInt("cache_budget"), 0) * 1024);
+	_prefetchedIcons = new ResourceHandle<IconSetResource>();
 
 	debug(1, "AckEngine initialized with system directory: %s", _systemDir.c_str());
 }
@@ -51,6 +91,16 @@ AckEngine::~AckEngine() {
 	freeResources();
 
 	delete _resourceManager;
+	delete _textRenderer;
+	_jobs.cancelAll();
+	delete _prefetchedIcons;
+	delete _cache;
+	delete _profiler;
+	_inputRecorder->endRecording(_tickCount);
+	delete _inputRecorder;
+	delete _snapshots;
+	if (_pack)
+		SearchMan.remove(ConfMan.get("pack_file"));
 	delete _graphicsManager;
 	delete _soundManager;
 	delete _scriptManager;
@@ -62,13 +112,20 @@ void AckEngine::initVars() {
 	_whatOpt = 1;
 	_oldWhatOpt = 1;
 	_passwordOk = true;
-	_registration = "registered"; // Default version.
+	_registration = kRegistrationFull; // Default version.
 	_checking = false;
 	_disableMouse = true;
-	_advName = "NONAME";
+	_advGeneration = 0;
+	_menuAdvGeneration = 0;
+	_daughterAdvGeneration = 0;
+	clearAdventure();
 	_lastCfgLoad = "NONAME";
 	_doserror = 0;
 	_dosexitcode = 0;
+	_tickMillis = 16;
+	_tickCount = 0;
+	_overlayShown = false;
+	_loadStage = kLoadStageIdle;
 
 	// Input states.
 	_mouseOn = false;
@@ -80,49 +137,54 @@ void AckEngine::initVars() {
 
 	// Pointers.
 	_icons = nullptr;
-	_graphic = nullptr;
+	memset(_iconDirty, 0, sizeof(_iconDirty));
 	_surface = nullptr;
 	_screenBuffer = nullptr;
 	_scrnl = 0;
 	_spaceMono = false;
+	_paletteValid = false;
+	_menuPasswordOk = false;
+	_menuValid = false;
+	_hoverOpt = 0;
+	_dirtyCount = 0;
 	_swapInfo = nullptr;
 	_p4ts = nullptr;
 	_block = nullptr;
+	_ack = nullptr;
 
 	_i = _i1 = _i2 = 0;
 
-	// Initialize screen height mapping array.
-	for (int i = 0; i < 40; i++) {
-		_scrnh[i] = i * 320;
+	// Initialize the row offset table for every screen line.
+	for (int i = 0; i < kScreenHeight; i++) {
+		_scrnh[i] = i * kScreenWidth;
 	}
 }
 
 void AckEngine::freeResources() {
-	// Free the allocated resources with additional error checks.
+	// Arena memory is released in one go; only the swap record has a
+	// destructor that must run first.
 	if (_swapInfo)
-		delete _swapInfo;
-	if (_icons)
-		delete[] _icons;
-	if (_block)
-		free(_block);
-	if (_graphic)
-		delete[] _graphic;
+		_swapInfo->~SwapInfoRec();
+	_swapInfo = nullptr;
+	_icons = nullptr;
+	_block = nullptr;
+	_graphic.clear();
 
-	if (_surface) {
-		_surface->free();
-		delete _surface;
-		_surface = nullptr;
-	}
+	// The surface does not own its pixels, so it is deleted without free().
+	delete _surface;
+	_surface = nullptr;
+	_screenBuffer = nullptr;
+	_systemArena.release();
 
-	if (_screenBuffer) {
-		free(_screenBuffer);
-		_screenBuffer = nullptr;
-	}
+	_graphic.setArena(nullptr);
+	_ack = nullptr;
+	_advArena.release();
 }
 
 Common::Error AckEngine::run() {
 	// Set up graphics via ScummVM surface creation.
 	initGraphics(kScreenWidth, kScreenHeight);
+	setDebugger(new Console(this));
 
 	// Create the manager objects.
 	_graphicsManager = new GraphicsManager(this);
@@ -133,8 +195,39 @@ Common::Error AckEngine::run() {
 	if (allocateResources() != Common::kNoError)
 		return Common::kBadError;
 
+	if (!ConfMan.get("pack_file").empty()) {
+		_pack = PackArchive::open(ConfMan.get("pack_file"));
+		if (_pack) {
+			debugC(kDebugIO, "Using data pack %s", ConfMan.get("pack_file").c_str());
+			SearchMan.add(ConfMan.get("pack_file"), _pack, 100, true);
+		}
+	}
+
+	int tickRate = CLIP(ConfMan.getInt("tick_rate"), 1, 1000);
+	_tickMillis = 1000 / tickRate;
+
+	if (!ConfMan.get("replay_input").empty())
+		_inputRecorder->startReplay(ConfMan.get("replay_input"), ConfMan.getBool("replay_fast"));
+	else if (!ConfMan.get("record_input").empty())
+		_inputRecorder->startRecording(ConfMan.get("record_input"));
+
 	// Initialize game state (reading configuration, fonts, icons, etc.)
 	initGameState();
+	if (shouldQuit())
+		return Common::kNoError;
+
+	// A save picked in the launcher is restored over the fresh state.
+	if (ConfMan.hasKey("save_slot")) {
+		int slot = ConfMan.getInt("save_slot");
+		if (loadGameState(slot) != Common::kNoError)
+			warning("Could not load save slot %d", slot);
+	}
+
+	int benchIterations = ConfMan.getInt("benchmark");
+	if (benchIterations > 0) {
+		debug("%s", Benchmark(this).run(benchIterations).c_str());
+		return Common::kNoError;
+	}
 
 	// Enter the main menu loop.
 	mainMenuLoop();
@@ -143,28 +236,26 @@ Common::Error AckEngine::run() {
 }
 
 Common::Error AckEngine::allocateResources() {
-	_surface = new Graphics::Surface();
-	if (!_surface->create(kScreenWidth, kScreenHeight, Graphics::PixelFormat::createFormatCLUT8()))
-		return Common::kBadError;
-
-	_screenBuffer = (byte *)malloc(kScreenWidth * kScreenHeight);
-	if (!_screenBuffer)
+	const uint32 frameSize = kScreenWidth * kScreenHeight;
+	const uint32 blockSize = (kBlockSize + 1) * sizeof(void *);
+	if (!_systemArena.reserve(Arena::footprint(frameSize) + Arena::footprint(blockSize) +
+	                          Arena::footprint(sizeof(Tile) * (kMaxIcons + 1)) +
+	                          Arena::footprint(sizeof(SwapInfoRec))))
 		return Common::kNoMemoryError;
-	memset(_screenBuffer, 0, kScreenWidth * kScreenHeight);
 
-	// Allocate memory for game assets.
-	_block = (byte *)malloc((kBlockSize + 1) * sizeof(void *));
-	if (!_block)
-		return Common::kNoMemoryError;
-
-	_icons = new GrapArray256[kMaxIcons + 1];
-	memset(_icons, 0, sizeof(GrapArray256) * (kMaxIcons + 1));
+	// The surface is the only framebuffer: drawing code writes straight into
+	// it through _screenBuffer, which relies on rows being tightly packed.
+	_screenBuffer = _systemArena.allocate<byte>(frameSize);
+	_surface = new Graphics::Surface();
+	_surface->init(kScreenWidth, kScreenHeight, kScreenWidth, _screenBuffer, Graphics::PixelFormat::createFormatCLUT8());
 
-	_graphic = new Grap256Unit[kGrapsSize + 1 + 4];
-	memset(_graphic, 0, sizeof(Grap256Unit) * (kGrapsSize + 1 + 4));
+	// Allocate memory for game assets.
+	_block = _systemArena.allocate<byte>(blockSize);
+	_icons = _systemArena.allocate<Tile>(kMaxIcons + 1);
+	_swapInfo = new (_systemArena.allocate<SwapInfoRec>()) SwapInfoRec();
 
-	_swapInfo = new SwapInfoRec();
-	memset(_swapInfo, 0, sizeof(SwapInfoRec));
+	if (!resetAdventureArena())
+		return Common::kNoMemoryError;
 
 	return Common::kNoError;
 }
@@ -173,23 +264,24 @@ void AckEngine::initGameState() {
 	debug(1, "Initializing game state");
 
 	// Set default adventure file and prepare loading routine.
-	_advName = "ACKDATA1";
+	setAdventure("ACKDATA1");
 	loadFont();
-	displayText(kScreenWidth / 2 - 30, 60, 0, "Loading...");
+	displayText((kScreenWidth / 2 - 40) / 4, 60, 0, "Loading...");
+	updateScreen();
 	loadBmpPalette(kAckVersion, "PALETTE2", _systemDir);
 
 	_lastCfgLoad = "NONAME";
-	_advName = "NONAME";
+	clearAdventure();
 
-	// Load icons with error checking.
-	loadIcons("ACKDATA1.ICO");
+	// Decode the icons in the slack of the adventure load's ticks; the first
+	// redisplay() finishes whatever is left.
+	prefetchIcons("ACKDATA1.ICO");
 
-	// Sample mapping for graphics registration.
-	_i = 0;
-	_graphic[_i + 241] = _icons[_i + 23];
-	_graphic[_i + 242] = _icons[_i + 9];
-	_graphic[_i + 243] = _icons[_i + 24];
-	_graphic[_i + 244] = _icons[_i + 11];
+	// Slots 241-244 show system icons unless the adventure defines them.
+	_graphic.alias(241, &_icons[23]);
+	_graphic.alias(242, &_icons[9]);
+	_graphic.alias(243, &_icons[24]);
+	_graphic.alias(244, &_icons[11]);
 
 	clearScreen();
 
@@ -206,352 +298,799 @@ void AckEngine::processParameters() {
 	Common::String paramStr = getParameter(0);
 	if (!paramStr.empty() && paramStr[0] != '-') {
 		displayText(10, 60, 0, "Loading Adventure...");
-		_advName = paramStr;
-		_ds = "N ";
-		_daughter = _advName + " " + _ds + Common::String::format("%d", kPalette);
-		if (!_spaceMono)
-			_daughter += " F";
+		setAdventure(paramStr);
+		buildDaughterCommand();
 
+		_loadStage = kLoadStageConfig;
+		runAdventureLoad();
+	}
+}
+
+void AckEngine::runAdventureLoad() {
+	// Advance the load one stage per tick, keeping the event queue drained
+	// and the progress bar current so the window stays responsive.
+	while (_loadStage != kLoadStageIdle) {
+		uint32 tickStart = _system->getMillis();
+		if (!handleEvents()) {
+			_loadStage = kLoadStageIdle;
+			return;
+		}
+		stepAdventureLoad();
+		drawLoadProgress();
+		updateScreen();
+		waitForNextTick(tickStart);
+	}
+}
+
+void AckEngine::stepAdventureLoad() {
+	switch (_loadStage) {
+	case kLoadStageConfig:
 		// Load adventure data with extra verification (as in the Pascal code).
-		if (loadAdventure(_advName)) {
-			_i1 = 2;
-			if (_graphic[_i1].data[1][1] != 255) {
-				_i = _dosexitcode;
-				_i1 = 1;
-				_hres = "";
-				for (_i = 1; _i <= _graphic[_i1].data[1][1]; _i++) {
-					_hres += (char)_graphic[_i1].data[_i + 1][1];
-				}
-				_i1 = 2;
-				if (_graphic[_i1].data[1][1] == 1)
-					_passwordOk = false;
-				if (_graphic[_i1].data[1][1] == 2)
-					_passwordOk = true;
-				_advName = _hres;
-				if (_advName != "NONAME") {
-					loadFont();
-					loadGraps();
-				} else {
-					_advName = _systemDir + "ACKDATA1";
-					loadFont();
-					_advName = "NONAME";
-				}
-			}
+		_loadStage = loadAdventure(_advName) ? kLoadStageHandoff : kLoadStageIdle;
+		break;
+	case kLoadStageHandoff:
+		_i1 = 2;
+		if (_graphic[_i1].pixels[0][0] == 255) {
+			_loadStage = kLoadStageIdle;
+			break;
 		}
+		_i = _dosexitcode;
+		_i1 = 1;
+		for (_i = 1; _i <= _graphic[_i1].pixels[0][0] && _i < kTileSize; _i++)
+			_hres[_i - 1] = (char)_graphic[_i1].pixels[_i][0];
+		_hres[_i - 1] = 0;
+		_i1 = 2;
+		if (_graphic[_i1].pixels[0][0] == 1)
+			_passwordOk = false;
+		if (_graphic[_i1].pixels[0][0] == 2)
+			_passwordOk = true;
+		setAdventure(_hres);
+		_loadStage = kLoadStageFont;
+		break;
+	case kLoadStageFont:
+		if (_advLoaded) {
+			loadFont();
+			_loadStage = kLoadStageGraphics;
+		} else {
+			_advName = _systemDir + "ACKDATA1";
+			loadFont();
+			clearAdventure();
+			_loadStage = kLoadStageIdle;
+		}
+		break;
+	case kLoadStageGraphics:
+		loadGraps();
+		_loadStage = kLoadStageIdle;
+		break;
+	default:
+		_loadStage = kLoadStageIdle;
+		break;
 	}
 }
 
+void AckEngine::drawLoadProgress() {
+	const Common::Rect bar(40, 72, kScreenWidth - 40, 78);
+	int done = (_loadStage == kLoadStageIdle) ? kLoadStageCount : _loadStage - 1;
+	int fillWidth = (bar.width() - 2) * done / kLoadStageCount;
+
+	for (int y = bar.top; y < bar.bottom; y++) {
+		byte *row = screenPixel(bar.left, y);
+		if (y == bar.top || y == bar.bottom - 1) {
+			memset(row, 1, bar.width());
+		} else {
+			row[0] = row[bar.width() - 1] = 1;
+			memset(row + 1, 1, fillWidth);
+			memset(row + 1 + fillWidth, 0, bar.width() - 2 - fillWidth);
+		}
+	}
+	markDirty(bar);
+}
+
 void AckEngine::loadBmpPalette(int version, const Common::String &name, const Common::String &sysdir) {
-	debug(kDebugGraphics, "Loading palette for %s (v%d)", name.c_str(), version);
+	debugC(kDebugGraphics, "Loading palette for %s (v%d)", name.c_str(), version);
+	ACK_PROFILE(kTimerLoadPalette);
 
 	Common::String palettePath = sysdir + name + ".PAL";
+	ResourceHandle<PaletteResource> cached = _cache->get<PaletteResource>(palettePath);
+	if (cached.isValid()) {
+		applyPalette(cached->palette.rgb);
+		return;
+	}
+
 	Common::File paletteFile;
-	if (!paletteFile.open(palettePath)) {
-		palettePath = sysdir + "PALETTE.PAL";
-		if (!paletteFile.open(palettePath)) {
-			warning("Could not open palette file %s", palettePath.c_str());
+	if (!openDataFile(paletteFile, palettePath)) {
+		Common::String fallbackPath = sysdir + "PALETTE.PAL";
+		if (!openDataFile(paletteFile, fallbackPath)) {
+			warning("Could not open palette file %s", fallbackPath.c_str());
 			return;
 		}
 	}
-
-	PaletteRec palette[256];
-	for (int i = 0; i < 256; i++) {
-		palette[i].r = paletteFile.readByte();
-		palette[i].g = paletteFile.readByte();
-		palette[i].b = paletteFile.readByte();
-	}
+	_profiler->count(kCounterFileOpens);
+
+	// The file holds 256 6-bit VGA triplets; scale them to 8 bits in place.
+	PaletteResource *res = new PaletteResource();
+	_profiler->count(kCounterResourceAllocs);
+	byte *rgb = res->palette.rgb;
+	memset(rgb, 0, sizeof(res->palette.rgb));
+	_profiler->count(kCounterBytesRead, paletteFile.read(rgb, sizeof(res->palette.rgb)));
 	paletteFile.close();
+	for (uint i = 0; i < sizeof(res->palette.rgb); i++)
+		rgb[i] <<= 2;
 
-	byte palData[256 * 3];
-	for (int i = 0; i < 256; i++) {
-		palData[i * 3] = palette[i].r * 4;
-		palData[i * 3 + 1] = palette[i].g * 4;
-		palData[i * 3 + 2] = palette[i].b * 4;
-	}
+	ResourceHandle<PaletteResource> palette = _cache->put(palettePath, res);
+	applyPalette(palette->palette.rgb);
+}
+
+void AckEngine::applyPalette(const byte *palData) {
+	// Re-uploading an identical palette makes some backends flicker.
+	if (_paletteValid && !memcmp(_currentPalette, palData, sizeof(_currentPalette)))
+		return;
+
+	memcpy(_currentPalette, palData, sizeof(_currentPalette));
+	_paletteValid = true;
 
+	// The screen stays CLUT8 on purpose. Backends like OpenGL keep the
+	// palette on the GPU and look it up there, so a change is a 768-byte
+	// upload rather than a repaint of every pixel.
 	_system->getPaletteManager()->setPalette(palData, 0, 256);
 }
 
-void AckEngine::menuSkinBmp() {
-	debug(kDebugGraphics, "Loading menu skin bitmap");
+bool AckEngine::loadMenuSkin(Graphics::Surface &skin) {
+	debugC(kDebugGraphics, "Loading menu skin bitmap");
 
+	Common::String name = _systemDir + "ACKDATA0.DAT";
 	Common::File bmpFile;
-	byte header[54];
-	byte line[320];
-	int i, i2;
+	if (!openDataFile(bmpFile, name))
+		return false;
+	_profiler->count(kCounterFileOpens);
 
-	Common::String name = _systemDir + "ACKDATA0.DAT";
-	if (bmpFile.open(name)) {
-		bmpFile.read(header, 54);
-		i2 = header[50];
-		if (i2 == 0)
-			i2 = 256;
-		bmpFile.seek(54 + (i2 * 4), SEEK_SET);
-
-		for (i = 0; i < kScreenHeight; i++) {
-			bmpFile.read(line, kScreenWidth);
-			memcpy(_screenBuffer + (kScreenHeight - 1 - i) * kScreenWidth, line, kScreenWidth);
+	// Pull the whole bitmap in with a single read and decode it from memory.
+	uint32 size = bmpFile.size();
+	byte *data = (byte *)malloc(size);
+	if (!data)
+		return false;
+	_profiler->count(kCounterResourceAllocs);
+	uint32 got = bmpFile.read(data, size);
+	_profiler->count(kCounterBytesRead, got);
+	bmpFile.close();
+
+	SkinHeader header;
+	if (got != size || !header.parse(data, size)) {
+		warning("Unsupported menu skin %s", name.c_str());
+		free(data);
+		return false;
+	}
+
+	// Store the skin top-down so that showing it is a straight copy.
+	skin.create(header.width, header.height, Graphics::PixelFormat::createFormatCLUT8());
+	_profiler->count(kCounterResourceAllocs);
+	for (int y = 0; y < header.height; y++) {
+		int srcRow = header.topDown ? y : header.height - 1 - y;
+		memcpy(skin.getBasePtr(0, y), data + header.dataOffset + srcRow * header.linePitch, header.width);
+	}
+
+	free(data);
+	return true;
+}
+
+void AckEngine::menuSkinBmp(const Common::Rect &area) {
+	ACK_PROFILE(kTimerMenuSkin);
+	ResourceHandle<SkinResource> skin = _cache->get<SkinResource>("ACKDATA0.DAT");
+	if (!skin.isValid()) {
+		SkinResource *res = new SkinResource();
+		_profiler->count(kCounterResourceAllocs);
+		if (!loadMenuSkin(res->surface)) {
+			delete res;
+			return;
 		}
+		skin = _cache->put("ACKDATA0.DAT", res);
+	}
 
-		bmpFile.close();
-		updateScreen();
+	const Graphics::Surface &surface = skin->surface;
+	Common::Rect r(area);
+	r.clip(Common::Rect(surface.w, surface.h));
+	if (r.isEmpty())
+		return;
+	for (int y = r.top; y < r.bottom; y++)
+		memcpy(screenPixel(r.left, y), surface.getBasePtr(r.left, y), r.width());
+	markDirty(r);
+}
+
+void AckEngine::markDirty(const Common::Rect &r) {
+	Common::Rect rect(r);
+	rect.clip(kScreenWidth, kScreenHeight);
+	if (rect.isEmpty())
+		return;
+
+	// Fold every overlapping rect into the new one; a merge can make it reach
+	// rects it did not touch before, so rescan from the start after each one.
+	for (uint i = 0; i < _dirtyCount;) {
+		if (_dirtyRects[i].intersects(rect)) {
+			rect.extend(_dirtyRects[i]);
+			_dirtyRects[i] = _dirtyRects[--_dirtyCount];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+	_dirtyRects[_dirtyCount++] = rect;
+
+	// Past this many fragments a single full-frame present is cheaper.
+	if (_dirtyCount > kMaxDirtyRects) {
+		_dirtyRects[0] = Common::Rect(kScreenWidth, kScreenHeight);
+		_dirtyCount = 1;
 	}
 }
 
 void AckEngine::updateScreen() {
-	if (_surface && _screenBuffer) {
-		memcpy(_surface->getPixels(), _screenBuffer, kScreenWidth * kScreenHeight);
-		_system->copyRectToScreen(_surface->getPixels(), _surface->pitch,
-		                           0, 0, kScreenWidth, kScreenHeight);
-		_system->updateScreen();
+	if (!_surface || !_screenBuffer)
+		return;
+
+	drawProfileOverlay();
+	if (_dirtyCount == 0)
+		return;
+
+	ACK_PROFILE(kTimerUpdateScreen);
+	_profiler->count(kCounterPresents);
+
+	for (uint i = 0; i < _dirtyCount; i++) {
+		const Common::Rect &r = _dirtyRects[i];
+		_system->copyRectToScreen(_surface->getBasePtr(r.left, r.top), _surface->pitch,
+		                           r.left, r.top, r.width(), r.height());
 	}
+	_dirtyCount = 0;
+	_system->updateScreen();
 }
 
 Common::String AckEngine::version(byte v) {
 	return Common::String::format("V%d.%d", v / 10, v % 10);
 }
 
+bool AckEngine::resetAdventureArena() {
+	// Graphic numbers are bytes in the original's data files, which bounds
+	// the tiles any adventure can bring; its config record rides along. The
+	// placeholder hand-off slots are allocated first and never reclaimed.
+	// Until loadGraps() can size _graphic from the adventure, room for the
+	// bound is reserved whatever the adventure uses.
+	const uint32 tileBytes = sizeof(Tile) * (kGrapsSize + kMaxGraphics);
+	_graphic.setArena(nullptr);
+	_ack = nullptr;
+	if (!_advArena.reserve(Arena::footprint(sizeof(MasterRec)) + Arena::footprint(tileBytes))) {
+		warning("Could not allocate the adventure arena");
+		return false;
+	}
+	_profiler->count(kCounterResourceAllocs);
+
+	_ack = _advArena.allocate<MasterRec>();
+	_graphic.setArena(&_advArena);
+	_mapView.invalidate();
+
+	// Until the adventure brings its own tiles, keep the slots the hand-off
+	// from the original's daughter process reads.
+	_graphic.resize(kGrapsSize);
+	return true;
+}
+
 void AckEngine::loadConfig() {
-	debug(kDebugIO, "Loading configuration for adventure: %s", _advName.c_str());
+	debugC(kDebugIO, "Loading configuration for adventure: %s", _advName.c_str());
 
 	Common::String masterFile = _advName + "MASTER.DAT";
-	Common::File ackFile;
+	ResourceHandle<MasterResource> master = _cache->get<MasterResource>(masterFile);
+	if (!master.isValid()) {
+		Common::File ackFile;
+		if (!openDataFile(ackFile, masterFile)) {
+			clearAdventure();
+			return;
+		}
 
-	if (!ackFile.open(masterFile)) {
-		_advName = "NONAME";
+		_profiler->count(kCounterFileOpens);
+		MasterResource *res = new MasterResource();
+		_profiler->count(kCounterResourceAllocs);
+		bool ok = res->master.load(ackFile);
+		_profiler->count(kCounterBytesRead, ackFile.pos());
+		ackFile.close();
+		if (!ok) {
+			warning("Could not read %s", masterFile.c_str());
+			delete res;
+			clearAdventure();
+			return;
+		}
+		master = _cache->put(masterFile, res);
+	}
+
+	if (!_ack) {
+		clearAdventure();
 		return;
 	}
+	*_ack = master->master;
+	loadBmpPalette(_ack->ackVersion, _advName, _systemDir);
+}
 
-	ackFile.read(&_ack, sizeof(MasterRec));
-	ackFile.close();
-	loadBmpPalette(_ack.ackVersion, _advName, _systemDir);
+void AckEngine::setAdventure(const Common::String &name) {
+	// The daughter programs hand back "NONAME" when nothing is loaded; that
+	// is the only place the placeholder is compared as a string.
+	_advName = name;
+	_advLoaded = name != "NONAME";
+	_advGeneration++;
 }
 
-void AckEngine::loadIcons(const Common::String &fn) {
-	debug(kDebugIO, "Loading icons from: %s", fn.c_str());
+void AckEngine::clearAdventure() {
+	_advName = "NONAME";
+	_advLoaded = false;
+	_advGeneration++;
+}
 
-	Common::File iconFile;
-	if (!iconFile.open(_systemDir + fn)) {
-		warning("Could not open icons file: %s", (_systemDir + fn).c_str());
-		return;
+void AckEngine::invalidateConfig() {
+	// Called when the adventure's configuration may have been edited; the
+	// next redisplay() rereads MASTER.DAT and rebuilds the menu from it.
+	_cache->invalidate(kResourceMaster, _advName + "MASTER.DAT");
+	_menuValid = false;
+}
+
+Common::String AckEngine::packMember(const Common::String &path) const {
+	// Pack members are named relative to the data directory.
+	if (!_systemDir.empty() && path.hasPrefix(_systemDir))
+		return Common::String(path.c_str() + _systemDir.size());
+	return path;
+}
+
+bool AckEngine::dataFileExists(const Common::String &path) const {
+	// A packed file is found without touching the file system.
+	if (_pack && _pack->hasFile(Common::Path(packMember(path))))
+		return true;
+	return Common::File::exists(path);
+}
+
+bool AckEngine::openDataFile(Common::File &file, const Common::String &path) {
+	if (_pack) {
+		Common::Path member(packMember(path));
+		if (_pack->hasFile(member) && file.open(member, *_pack)) {
+			_profiler->count(kCounterResourceAllocs); // The unpacked member.
+			return true;
+		}
 	}
+	return file.open(path);
+}
 
-	for (int i = 1; i <= kMaxIcons; i++) {
-		if (iconFile.eos())
-			break;
-		iconFile.read(&_icons[i], sizeof(Grap256Unit));
+bool AckEngine::writeDataPack(const Common::String &packName, bool compress) {
+	Common::StringArray files;
+	files.push_back("ACKDATA0.DAT");
+	files.push_back("ACKDATA1.ICO");
+	files.push_back("PALETTE.PAL");
+	files.push_back("PALETTE2.PAL");
+	if (_advLoaded) {
+		files.push_back(_advName + "MASTER.DAT");
+		files.push_back(_advName + ".PAL");
+	}
+	return writePack(packName, _systemDir, files, compress);
+}
+
+void AckEngine::loadIcons(const Common::String &fn) {
+	// The icon set only changes on disk through saveIcons(), which keeps the
+	// cache in step, so a name match means the tiles in memory are current.
+	if (fn == _iconCacheName)
+		return;
+
+	ACK_PROFILE(kTimerLoadIcons);
+	if (_jobs.isPending(fn))
+		_jobs.finish(fn);
+	ResourceHandle<IconSetResource> set = _cache->get<IconSetResource>(fn);
+	if (!set.isValid()) {
+		debugC(kDebugIO, "Loading icons from: %s", fn.c_str());
+
+		Common::File iconFile;
+		if (!openDataFile(iconFile, _systemDir + fn)) {
+			warning("Could not open icons file: %s", (_systemDir + fn).c_str());
+			return;
+		}
+		_profiler->count(kCounterFileOpens);
+
+		IconSetResource *res = new IconSetResource();
+		_profiler->count(kCounterResourceAllocs);
+		memset(res->tiles, 0, sizeof(res->tiles));
+		Grap256Unit rec;
+		for (int i = 1; i <= kMaxIcons; i++) {
+			if (iconFile.read(&rec, sizeof(Grap256Unit)) != sizeof(Grap256Unit))
+				break;
+			_profiler->count(kCounterBytesRead, sizeof(Grap256Unit));
+			res->tiles[i].decode(rec);
+		}
+
+		iconFile.close();
+		set = _cache->put(fn, res);
 	}
 
-	iconFile.close();
+	memcpy(_icons, set->tiles, sizeof(set->tiles));
+	if (_prefetchedIcons->get() == set.get())
+		_prefetchedIcons->reset();
+	_iconCacheName = fn;
+	_iconImageName.clear();
+}
+
+void AckEngine::iconChanged(int i) {
+	// Editors call this after changing _icons[i], so the next save encodes it.
+	assert(i >= 1 && i <= kMaxIcons);
+	_iconDirty[i] = true;
+}
+
+void AckEngine::prefetchIcons(const Common::String &fn) {
+	if (_jobs.isPending(fn) || _cache->get<IconSetResource>(fn).isValid())
+		return;
+
+	Common::File *iconFile = new Common::File();
+	if (!openDataFile(*iconFile, _systemDir + fn)) {
+		delete iconFile;
+		return;
+	}
+	_profiler->count(kCounterFileOpens);
+	_profiler->count(kCounterResourceAllocs, 3); // The file, the job and its icon set.
+	debugC(kDebugIO, "Prefetching icons from: %s", fn.c_str());
+	_jobs.schedule(new TileSetJob(fn, iconFile, _cache, _prefetchedIcons));
 }
 
 void AckEngine::saveIcons(const Common::String &fn) {
-	debug(kDebugIO, "Saving icons to: %s", fn.c_str());
-	loadIcons(fn);
+	debugC(kDebugIO, "Saving icons to: %s", fn.c_str());
+
+	// Re-encode only the tiles edited since the last save of this file; if
+	// there are none, the file already holds exactly what is in memory.
+	bool fresh = _iconImageName != fn;
+	bool changed = fresh;
+	if (fresh)
+		_iconImage.resize(kMaxIcons * sizeof(Grap256Unit));
+	for (int i = 1; i <= kMaxIcons; i++) {
+		if (fresh || _iconDirty[i]) {
+			_icons[i].encode(*(Grap256Unit *)&_iconImage[(i - 1) * sizeof(Grap256Unit)]);
+			changed = true;
+		}
+	}
+	if (!changed)
+		return;
+
+	// Save files cannot be patched in place, so the image goes out whole,
+	// in one write.
 	Common::OutSaveFile *iconFile = _system->getSaveFileManager()->openForSaving(_systemDir + fn);
 	if (!iconFile)
 		return;
-	for (int i = 1; i <= kMaxIcons; i++) {
-		iconFile->write(&_icons[i], sizeof(Grap256Unit));
-	}
+	_profiler->count(kCounterResourceAllocs);
+	iconFile->write(&_iconImage[0], _iconImage.size());
 	iconFile->finalize();
+	bool ok = !iconFile->err();
 	delete iconFile;
+	if (!ok) {
+		warning("Could not write icons file: %s", fn.c_str());
+		_iconImageName.clear();
+		return;
+	}
+	memset(_iconDirty, 0, sizeof(_iconDirty));
+	_iconImageName = fn;
+
+	// The file now holds exactly what is in memory.
+	IconSetResource *res = new IconSetResource();
+	_profiler->count(kCounterResourceAllocs);
+	memcpy(res->tiles, _icons, sizeof(res->tiles));
+	_cache->put(fn, res);
+	_iconCacheName = fn;
 }
 
 void AckEngine::putIcon(int xb, int yy, int bb) {
 	if ((_mouseOn) && (_mouseActive))
 		hideMouse();
 
+	// The icons are kept as loaded, key color included, so that saving them
+	// is lossless; on the menu the key shows as black, as in the original.
 	int x = xb * 4;
-	for (int i = 1; i <= 16; i++) {
-		memcpy(_screenBuffer + x + _scrnh[yy + i], &_icons[bb].data[i][1], 16);
+	byte *dst = screenBlock(x, yy + 1, kTileSize, kTileSize);
+	for (int i = 0; i < kTileSize; i++)
+		memset(dst + i * kScreenWidth, 0, kTileSize);
+	blitTileFixed<kScreenWidth, kBlitKeyed>(dst, _icons[bb]);
+	markDirty(Common::Rect(x, yy + 1, x + 16, yy + 17));
+}
+
+void AckEngine::drawMap() {
+	// The view keeps its own terrain layer, so only cells that changed since
+	// the last call are written and presented.
+	markDirty(_mapView.draw(_screenBuffer, kScreenWidth));
+}
+
+// Screen layout of the main menu options, in menu order. Columns are in
+// 4-pixel units; the icon sits one line below the label row.
+static const struct {
+	int iconCol, row, icon, textCol;
+	const char *labels[2];
+} kMenuLayout[] = {
+	{  3,  57,  1,  8, { "SELECT/CREATE",  " ADVENTURE"     } },
+	{ 43,  57,  2, 48, { "PLAY ADVENTURE", nullptr          } },
+	{  3,  81,  3,  8, { "CONFIGURE",      " ADVENTURE"     } },
+	{ 43,  81,  4, 48, { "IMPORT FILES,",  "EXPORT REPORTS" } },
+	{  3, 105,  5,  8, { "EDIT FONT",      nullptr          } },
+	{ 43, 105,  6, 48, { "EDIT GRAPHIC",   " TILES"         } },
+	{  3, 129,  7,  8, { "EDIT OBJECTS,",  "ITEMS, TERRAIN" } },
+	{ 43, 129,  8, 48, { "EDIT MESSAGES",  "AND DIALOGUE"   } },
+	{  3, 153,  9,  8, { "EDIT MAPS AND",  "REGIONS"        } },
+	{ 43, 153, 10, 48, { "EDIT PEOPLE",    "AND CREATURES"  } },
+	{  3, 177, 28,  8, { "EDIT MACROS",    "(ADVANCED)"     } },
+	{ 43, 177, 12, 48, { "QUIT",           "EXIT TO DOS"    } }
+};
+
+bool AckEngine::menuStateChanged() const {
+	return !_menuValid || _menuAdvGeneration != _advGeneration ||
+	       _menuRegistration != _registration || _menuPasswordOk != _passwordOk;
+}
+
+void AckEngine::buildMenu() {
+	// Picking up the adventure's configuration may reset _advName if its
+	// MASTER.DAT is gone, so snapshot the state only afterwards.
+	if (_advLoaded)
+		loadConfig();
+
+	bool loaded = _advLoaded;
+	bool unregistered = _registration == kRegistrationNone;
+
+	if (loaded) {
+		_menuTitle = "CURRENT ADVENTURE: " + _advName;
+		if (_ack->ackVersion != kAckVersion)
+			_menuSubtitle = "(CREATED WITH ACK " + version(_ack->ackVersion) + ")";
+		else
+			_menuSubtitle.clear();
+	} else {
+		_menuTitle = "No Adventure loaded.";
+		_menuSubtitle.clear();
 	}
-	_system->copyRectToScreen(_screenBuffer + x + _scrnh[yy + 1], kScreenWidth, x, yy + 1, 16, 16);
-	_system->updateScreen();
+
+	for (int x = 1; x <= kMenuOptions; x++) {
+		MenuOption &opt = _menuOptions[x];
+		opt.iconCol = kMenuLayout[x - 1].iconCol;
+		opt.row = kMenuLayout[x - 1].row;
+		opt.icon = kMenuLayout[x - 1].icon;
+		opt.textCol = kMenuLayout[x - 1].textCol;
+		opt.labels[0] = kMenuLayout[x - 1].labels[0];
+		opt.labels[1] = kMenuLayout[x - 1].labels[1];
+
+		if (x == 11 && unregistered) {
+			opt.icon = 11;
+			opt.labels[0] = "ORDERING";
+			opt.labels[1] = "INFORMATION";
+		}
+
+		// Some options are always available per the original design.
+		opt.enabled = (x == 1) || (x == 12) ||
+		              (unregistered && x == 11) ||
+		              (x == 2 && loaded) ||
+		              (loaded && _passwordOk);
+
+		int textWidth = strlen(opt.labels[0]);
+		if (opt.labels[1])
+			textWidth = MAX<int>(textWidth, strlen(opt.labels[1]));
+		int lines = opt.labels[1] ? 2 : 1;
+		opt.bounds = Common::Rect(opt.iconCol * 4, opt.row + 1, opt.iconCol * 4 + kTileSize, opt.row + 1 + kTileSize);
+		opt.bounds.extend(Common::Rect(opt.textCol * 4, opt.row,
+		                               opt.textCol * 4 + textWidth * kGlyphWidth, opt.row + lines * kGlyphHeight));
+	}
+
+	_menuHitGrid.clear();
+	for (int x = 1; x <= kMenuOptions; x++)
+		_menuHitGrid.addRegion(_menuOptions[x].bounds, x);
+	_menuHitGrid.build();
+	_hoverOpt = _menuHitGrid.hitTest(_mouseX, _mouseY);
+
+	_menuAdvGeneration = _advGeneration;
+	_menuAdvLoaded = _advLoaded;
+	_menuRegistration = _registration;
+	_menuPasswordOk = _passwordOk;
+	_menuValid = true;
 }
 
 void AckEngine::showOption(byte x, byte n, int16 mo) {
-	// Ensure some options are highlighted per the original design.
-	if (!((x == 1) || (x == 12) ||
-	      ((_registration == "none") && (x == 11)) ||
-	      ((x == 2) && (_advName != "NONAME")) ||
-	      ((_advName != "NONAME") && _passwordOk)))
-	{
+	const MenuOption &opt = _menuOptions[x];
+	if (!opt.enabled)
 		n += mo;
-	}
 
-	switch (x) {
-	case 1:
-		displayText(8, 57, n, "SELECT/CREATE");
-		displayText(8, 65, n, " ADVENTURE");
-		break;
-	case 2:
-		displayText(48, 57, n, "PLAY ADVENTURE");
-		break;
-	case 3:
-		displayText(8, 81, n, "CONFIGURE");
-		displayText(8, 89, n, " ADVENTURE");
-		break;
-	case 4:
-		displayText(48, 81, n, "IMPORT FILES,");
-		displayText(48, 89, n, "EXPORT REPORTS");
-		break;
-	case 5:
-		displayText(8, 105, n, "EDIT FONT");
-		break;
-	case 6:
-		displayText(48, 105, n, "EDIT GRAPHIC");
-		displayText(48, 113, n, " TILES");
-		break;
-	case 7:
-		displayText(8, 129, n, "EDIT OBJECTS,");
-		displayText(8, 137, n, "ITEMS, TERRAIN");
-		break;
-	case 8:
-		displayText(48, 129, n, "EDIT MESSAGES");
-		displayText(48, 137, n, "AND DIALOGUE");
-		break;
-	case 9:
-		displayText(8, 153, n, "EDIT MAPS AND");
-		displayText(8, 161, n, "REGIONS");
-		break;
-	case 10:
-		displayText(48, 153, n, "EDIT PEOPLE");
-		displayText(48, 161, n, "AND CREATURES");
-		break;
-	case 11:
-		if (_registration == "none") {
-			displayText(8, 177, n, "ORDERING");
-			displayText(8, 185, n, "INFORMATION");
+	displayText(opt.textCol, opt.row, n, opt.labels[0]);
+	if (opt.labels[1])
+		displayText(opt.textCol, opt.row + kGlyphHeight, n, opt.labels[1]);
+}
+
+void AckEngine::drawProfileOverlay() {
+	if (_profiler->isOverlayEnabled() && _textRenderer->hasFont()) {
+		const Common::Rect area(kScreenWidth, kGlyphHeight);
+		for (int y = area.top; y < area.bottom; y++)
+			memset(screenPixel(0, y), 0, area.width());
+		_textRenderer->drawText(_screenBuffer, kScreenWidth, kScreenWidth, kScreenHeight, 0, 0, 1,
+		                        _profiler->getOverlayText(), false);
+		markDirty(area);
+		_overlayShown = true;
+	} else if (_overlayShown) {
+		// Put back only what the overlay covered: the loading screen is blank
+		// there and the menu shows its skin, so the options and their
+		// highlight are left alone.
+		const Common::Rect area(kScreenWidth, kGlyphHeight);
+		_overlayShown = false;
+		if (_loadStage != kLoadStageIdle) {
+			for (int y = area.top; y < area.bottom; y++)
+				memset(screenPixel(0, y), 0, area.width());
+			markDirty(area);
 		} else {
-			displayText(8, 177, n, "EDIT MACROS");
-			displayText(8, 185, n, "(ADVANCED)");
+			menuSkinBmp(area);
 		}
-		break;
-	case 12:
-		displayText(48, 177, n, "QUIT");
-		displayText(48, 185, n, "EXIT TO DOS");
-		break;
 	}
 }
 
 void AckEngine::redisplay() {
-	// Load configuration and refresh UI icons.
-	if (_advName != "NONAME")
-		loadConfig();
+	ACK_PROFILE(kTimerRedisplay);
+	// Only an adventure or registration change alters the menu itself; the
+	// assets it is drawn from are all cached, so repainting is cheap.
+	if (menuStateChanged())
+		buildMenu();
 
 	loadIcons("ACKDATA1.ICO");
-	for (int i = 1; i <= kMaxIcons; i++) {
-		for (int i1 = 1; i1 <= 16; i1++) {
-			for (int i2 = 1; i2 <= 16; i2++) {
-				if (_icons[i].data[i1][i2] == 222)
-					_icons[i].data[i1][i2] = 0;
-			}
-		}
-	}
 
 	clearScreen();
 	menuSkinBmp();
 
-	if (_advName != "NONAME") {
-		displayText(11, 34, 1, "CURRENT ADVENTURE: " + _advName);
-		if (_ack.ackVersion != kAckVersion)
-			displayText(15, 42, 1, "(CREATED WITH ACK " + version(_ack.ackVersion) + ")");
+	if (_menuAdvLoaded) {
+		displayText(11, 34, 1, _menuTitle);
+		if (!_menuSubtitle.empty())
+			displayText(15, 42, 1, _menuSubtitle);
 	} else {
-		displayText(20, 40, 1, "No Adventure loaded.");
-	}
-
-	putIcon(3, 57, 1);
-	putIcon(43, 57, 2);
-	putIcon(3, 81, 3);
-	putIcon(43, 81, 4);
-	putIcon(3, 105, 5);
-	putIcon(43, 105, 6);
-	putIcon(3, 129, 7);
-	putIcon(43, 129, 8);
-	putIcon(3, 153, 9);
-	putIcon(43, 153, 10);
-	if (_registration == "none")
-		putIcon(3, 177, 11);
-	else
-		putIcon(3, 177, 28);
-	putIcon(43, 177, 12);
+		displayText(20, 40, 1, _menuTitle);
+	}
 
-	// Redraw all menu options.
-	for (int i = 1; i <= 12; i++)
+	for (int i = 1; i <= kMenuOptions; i++) {
+		putIcon(_menuOptions[i].iconCol, _menuOptions[i].row, _menuOptions[i].icon);
 		showOption(i, 0, 1);
+	}
 }
 
 void AckEngine::checkRegistration() {
-	_registration = "REGISTERED"; // In ScummVM we treat all registrations as valid.
+	_registration = kRegistrationFull; // In ScummVM we treat all registrations as valid.
 }
 
 void AckEngine::displayText(int x, int y, int color, const Common::String &text) {
-	debug(kDebugGraphics, "Display text at (%d,%d) color %d: %s", x, y, color, text.c_str());
-	_graphicsManager->drawText(x, y, color, text);
-	updateScreen();
+	// x is a 4-pixel column, as in putIcon().
+	if (_textRenderer->hasFont()) {
+		markDirty(_textRenderer->drawText(_screenBuffer, kScreenWidth, kScreenWidth, kScreenHeight,
+		                                  x * 4, y, color, text));
+		return;
+	}
+
+	debugC(kDebugGraphics, "Display text at (%d,%d) color %d: %s", x, y, color, text.c_str());
+	_graphicsManager->drawText(x * 4, y, color, text);
+
+	// This renderer does not report its extent, so flag the rest of the
+	// 8-pixel text row; neighbours on the same row merge into one rect.
+	markDirty(Common::Rect(x * 4, y, kScreenWidth, y + 8));
 }
 
 void AckEngine::clearScreen() {
 	memset(_screenBuffer, 0, kScreenWidth * kScreenHeight);
-	memset(_surface->getPixels(), 0, kScreenWidth * kScreenHeight);
-	_system->fillScreen(0);
-	_system->updateScreen();
+	markDirty(Common::Rect(kScreenWidth, kScreenHeight));
+}
+
+void AckEngine::buildDaughterCommand() {
+	Common::strlcpy(_ds, "N ", sizeof(_ds));
+	snprintf(_dc, sizeof(_dc), " %s %s CH%s ", _ds, _ds, _ds);
+	snprintf(_daughter, sizeof(_daughter), "%s %s%d%s", _advName.c_str(), _ds, kPalette, _spaceMono ? "" : " F");
+	_daughterAdvGeneration = _advGeneration;
+}
+
+void AckEngine::waitForNextTick(uint32 tickStart) {
+	// Sleep away the rest of the tick so an idle menu does not spin a core.
+	if (_inputRecorder->isFastForward())
+		return;
+
+	// Spend the slack on queued decoding before sleeping through the rest.
+	_jobs.run(tickStart + _tickMillis);
+	uint32 elapsed = _system->getMillis() - tickStart;
+	if (elapsed < _tickMillis)
+		_system->delayMillis(_tickMillis - elapsed);
 }
 
 void AckEngine::mainMenuLoop() {
 	debug(1, "Entering main menu loop");
 
+	buildDaughterCommand();
+
 	do {
 		_checking = true;
-		_dc = Common::String::format(" %s", _ds.c_str());
-		_dc += Common::String::format(" %s CH", _ds.c_str());
-		_dc += Common::String::format("%s ", _ds.c_str());
-
 		_quitTime = false;
-		_ds = "N ";
-		_daughter = _advName + " " + _ds + Common::String::format("%d", kPalette);
-		if (!_spaceMono)
-			_daughter += " F";
+
+		// The command line only depends on the adventure, so rebuild it only
+		// after a menu command switched to another one.
+		if (_daughterAdvGeneration != _advGeneration)
+			buildDaughterCommand();
 
 		showOption(_whatOpt, 6, -2);
 		_menuCmd = 1;
 		_oldWhatOpt = _whatOpt;
 
 		do {
+			uint32 tickStart = _system->getMillis();
 			if (!handleEvents())
 				return;
 			if (_mouseOn)
 				trackMouse();
-			if (mouseIn(4, 57, 33, 73)) {
-				_whatOpt = 1;
-				_menuCmd = '\r';
-			}
 			if (_mouseOn)
 				checkMouseMenuRegions();
+
+			// Present everything drawn during this iteration at once.
+			updateScreen();
+			_profiler->endFrame();
+			if (_menuCmd == 1)
+				waitForNextTick(tickStart);
 		} while (_menuCmd == 1);
 
 		showOption(_oldWhatOpt, 0, 1);
 		processMenuCommand();
+		updateScreen();
 	} while (!_quitTime);
 }
 
+bool AckEngine::nextEvent(Common::Event &event, char &key) {
+	if (_inputRecorder->isReplaying()) {
+		// Live input is dropped so it cannot disturb the replay; only a quit
+		// request still gets through.
+		while (_eventMan->pollEvent(event)) {
+			if (event.type == Common::EVENT_QUIT) {
+				key = 0;
+				return true;
+			}
+		}
+
+		if (_inputRecorder->replay(_tickCount, event, key))
+			return true;
+		if (_inputRecorder->isReplayFinished(_tickCount)) {
+			// A fast replay is a headless run; one at the recorded pace hands
+			// over to live input unless asked to quit.
+			bool quit = _inputRecorder->isFastForward() || ConfMan.getBool("replay_quit");
+			_inputRecorder->stop();
+			if (quit)
+				quitGame();
+		}
+		return false;
+	}
+
+	if (!_eventMan->pollEvent(event))
+		return false;
+
+	key = (event.type == Common::EVENT_KEYDOWN) ? convertKeyCode(event.kbd.keycode) : 0;
+	if (_inputRecorder->isRecording()) {
+		switch (event.type) {
+		case Common::EVENT_QUIT:
+		case Common::EVENT_KEYDOWN:
+		case Common::EVENT_MOUSEMOVE:
+		case Common::EVENT_LBUTTONDOWN:
+			_inputRecorder->record(_tickCount, event, key);
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
 bool AckEngine::handleEvents() {
+	// Every call is one engine tick; recorded input is replayed by tick.
+	_tickCount++;
+
 	Common::Event event;
-	while (_eventMan->pollEvent(event)) {
+	char key;
+	while (nextEvent(event, key)) {
 		switch (event.type) {
 		case Common::EVENT_QUIT:
 			return false;
 		case Common::EVENT_KEYDOWN:
-			_lastKeyPressed = convertKeyCode(event.kbd.keycode);
+			_lastKeyPressed = key;
 			_keyboardInput = true;
 			_menuCmd = _lastKeyPressed;
 			break;
 		case Common::EVENT_MOUSEMOVE:
 			_mouseX = event.mouse.x;
 			_mouseY = event.mouse.y;
+			_hoverOpt = _menuHitGrid.hitTest(_mouseX, _mouseY);
 			break;
 		case Common::EVENT_LBUTTONDOWN:
+			_mouseX = event.mouse.x;
+			_mouseY = event.mouse.y;
 			_mouseClicked = true;
 			checkMouseClick();
 			break;
@@ -563,15 +1102,21 @@ bool AckEngine::handleEvents() {
 }
 
 void AckEngine::checkMouseClick() {
-	if (mouseIn(48, 177, 64, 185))
-		_menuCmd = 'q';
+	// Clicking an option selects it, as Return does for the highlighted one.
+	// Touch and replayed clicks need not follow a move, so the click's own
+	// position is looked up rather than the last hover.
+	_hoverOpt = _menuHitGrid.hitTest(_mouseX, _mouseY);
+	if (_hoverOpt) {
+		_whatOpt = _hoverOpt;
+		_menuCmd = '\r';
+	}
 }
 
 void AckEngine::checkMouseMenuRegions() {
-	if (mouseIn(4, 57, 33, 73) && _oldWhatOpt != 1) {
+	if (_hoverOpt && _hoverOpt != _oldWhatOpt) {
 		showOption(_oldWhatOpt, 0, 1);
-		_oldWhatOpt = 1;
-		_whatOpt = 1;
+		_oldWhatOpt = _hoverOpt;
+		_whatOpt = _hoverOpt;
 		showOption(_whatOpt, 6, -2);
 	}
 }
@@ -592,14 +1137,16 @@ void AckEngine::processMenuCommand() {
 			handleAdventureSelection();
 			break;
 		case 2:
-			if (_advName != "NONAME")
+			if (_advLoaded)
 				handleAdventurePlay();
 			break;
 		case 12:
 			_quitTime = true;
 			break;
 		default:
-			// Additional menu options could be handled here.
+			// Additional menu options could be handled here. They are the
+			// adventure editors, so what they return to may have changed.
+			invalidateConfig();
 			break;
 		}
 		break;
@@ -616,18 +1163,189 @@ void AckEngine::handleAdventureSelection() {
 void AckEngine::handleAdventurePlay() {
 	debug(1, "Starting adventure play...");
 	// Launch game play functionality.
+	_mapView.setTiles(&_graphic);
+	if (_mapView.hasMap()) {
+		drawMap();
+		updateScreen();
+	}
 }
 
 bool AckEngine::loadAdventure(const Common::String &name) {
 	debug(1, "Loading adventure: %s", name.c_str());
-	if (!Common::File::exists(_systemDir + name + "MASTER.DAT")) {
+	if (!dataFileExists(_systemDir + name + "MASTER.DAT")) {
 		warning("Adventure %s not found", name.c_str());
 		return false;
 	}
+	if (!resetAdventureArena())
+		return false;
 	loadConfig();
 	return true;
 }
 
+// Layout of the state image. Fields are little-endian at fixed offsets; the
+// adventure's tiles follow in slot order as raw pixels.
+enum {
+	kStateAdvName = 0,
+	kStateAdvNameSize = 16,
+	kStatePasswordOk = 16,
+	kStateRegistration = 17,
+	kStateWhatOpt = 18,
+	kStateMaster = 20,
+	kStateTileCount = kStateMaster + MasterRec::kFileSize,
+	kStateTiles = 96
+};
+
+void AckEngine::captureState(Common::Array<byte> &state) const {
+	uint count = _graphic.size();
+	state.resize(kStateTiles + count * sizeof(Tile));
+	memset(&state[0], 0, kStateTiles);
+
+	Common::strlcpy((char *)&state[kStateAdvName], _advName.c_str(), kStateAdvNameSize);
+	state[kStatePasswordOk] = _passwordOk ? 1 : 0;
+	state[kStateRegistration] = _registration;
+	WRITE_LE_INT16(&state[kStateWhatOpt], _whatOpt);
+	if (_ack) {
+		Common::MemoryWriteStream master(&state[kStateMaster], MasterRec::kFileSize);
+		_ack->save(master);
+	}
+	WRITE_LE_UINT16(&state[kStateTileCount], count);
+
+	for (uint i = 1; i <= count; i++)
+		memcpy(&state[kStateTiles + (i - 1) * sizeof(Tile)], _graphic[i].pixels, sizeof(Tile));
+}
+
+bool AckEngine::restoreState(const Common::Array<byte> &state) {
+	if (state.size() < kStateTiles)
+		return false;
+	uint count = READ_LE_UINT16(&state[kStateTileCount]);
+	if (count > kMaxGraphics || state.size() != kStateTiles + count * sizeof(Tile))
+		return false;
+
+	MasterRec master;
+	Common::MemoryReadStream masterStream(&state[kStateMaster], MasterRec::kFileSize);
+	if (!master.load(masterStream))
+		return false;
+
+	// Nothing is torn down until the save is known to be usable.
+	char name[kStateAdvNameSize + 1];
+	memcpy(name, &state[kStateAdvName], kStateAdvNameSize);
+	name[kStateAdvNameSize] = 0;
+	bool loaded = strcmp(name, "NONAME") != 0;
+	if (loaded && !dataFileExists(_systemDir + name + "MASTER.DAT")) {
+		warning("Adventure %s not found", name);
+		return false;
+	}
+	if (!resetAdventureArena())
+		return false;
+
+	setAdventure(name);
+	_passwordOk = state[kStatePasswordOk] != 0;
+	_registration = state[kStateRegistration] ? kRegistrationNone : kRegistrationFull;
+	_whatOpt = CLIP<int16>(READ_LE_INT16(&state[kStateWhatOpt]), 1, kMenuOptions);
+
+	// Building the menu rereads MASTER.DAT, so the saved record is applied
+	// over it afterwards, together with the palette it names.
+	buildMenu();
+	*_ack = master;
+	if (loaded)
+		loadBmpPalette(_ack->ackVersion, _advName, _systemDir);
+	else
+		loadBmpPalette(kAckVersion, "PALETTE2", _systemDir);
+
+	_graphic.resize(count);
+	for (uint i = 1; i <= count; i++)
+		memcpy(_graphic[i].pixels, &state[kStateTiles + (i - 1) * sizeof(Tile)], sizeof(Tile));
+	_mapView.invalidate();
+
+	redisplay();
+	showOption(_whatOpt, 6, -2);
+	_oldWhatOpt = _whatOpt;
+	return true;
+}
+
+bool AckEngine::hasFeature(EngineFeature f) const {
+	return (f == kSupportsLoadingDuringRuntime) ||
+	       (f == kSupportsSavingDuringRuntime);
+}
+
+bool AckEngine::canLoadGameStateCurrently(Common::U32String *msg) {
+	return _surface && _loadStage == kLoadStageIdle;
+}
+
+bool AckEngine::canSaveGameStateCurrently(Common::U32String *msg) {
+	return _surface && _loadStage == kLoadStageIdle;
+}
+
+Common::String AckEngine::getSaveStateName(int slot) const {
+	// Matches the names the meta engine lists.
+	return Common::String::format("%s.%02d", _targetName.c_str(), slot);
+}
+
+Common::Error AckEngine::saveGameState(int slot, const Common::String &desc, bool isAutosave) {
+	Common::OutSaveFile *out = _saveFileMan->openForSaving(getSaveStateName(slot));
+	if (!out)
+		return Common::kCreatingFileFailed;
+
+	// The header is what the meta engine and the save index read back.
+	TimeDate td;
+	_system->getTimeAndDate(td);
+	SaveIndexEntry entry;
+	entry.slot = slot;
+	entry.description = desc;
+	entry.day = td.tm_mday;
+	entry.month = td.tm_mon + 1;
+	entry.year = td.tm_year + 1900;
+	entry.hour = td.tm_hour;
+	entry.minutes = td.tm_min;
+	entry.playTime = getTotalPlayTime();
+
+	out->writeString(desc);
+	out->writeByte(0);
+	out->writeSint16LE(entry.day);
+	out->writeSint16LE(entry.month);
+	out->writeSint16LE(entry.year);
+	out->writeSint16LE(entry.hour);
+	out->writeSint16LE(entry.minutes);
+	out->writeUint32LE(entry.playTime);
+	out->writeByte(0); // No thumbnail.
+
+	// Autosaves overwrite a single slot, so they alone may be deltas: a new
+	// base image cannot strand an older save that still refers to the last.
+	captureState(_state);
+	bool ok = _snapshots->write(*out, _state, isAutosave);
+	out->finalize();
+	ok = ok && !out->err();
+	delete out;
+	if (!ok)
+		return Common::kWritingFailed;
+
+	// A missing index is started afresh; listSaves() rebuilds it if other
+	// saves exist that it does not list.
+	SaveIndex index(_targetName);
+	index.load();
+	index.update(entry);
+	index.save();
+	return Common::kNoError;
+}
+
+Common::Error AckEngine::loadGameState(int slot) {
+	Common::InSaveFile *in = _saveFileMan->openForLoading(getSaveStateName(slot));
+	if (!in)
+		return Common::kReadingFailed;
+
+	in->readString();
+	for (int i = 0; i < 5; i++)
+		in->readSint16LE();
+	uint32 playTime = in->readUint32LE();
+	bool ok = in->readByte() == 0 && _snapshots->read(*in, _state);
+	delete in;
+
+	if (!ok || !restoreState(_state))
+		return Common::kReadingFailed;
+	setTotalPlayTime(playTime);
+	return Common::kNoError;
+}
+
 char AckEngine::convertKeyCode(Common::KeyCode keycode) {
 	switch (keycode) {
 	case Common::KEYCODE_RETURN:
@@ -680,13 +1398,22 @@ void AckEngine::closeMouse() {
 }
 
 void AckEngine::loadFont() {
-	debug(kDebugIO, "Loading font");
+	debugC(kDebugIO, "Loading font");
 	_resourceManager->loadFont();
+
+	// ResourceManager keeps the font's glyphs to itself for now, so the atlas
+	// stays empty and displayText() draws through GraphicsManager. Once it
+	// exposes them, pass them to _textRenderer->setFont() here, so each
+	// adventure's font rebuilds the atlas.
 }
 
 void AckEngine::loadGraps() {
-	debug(kDebugIO, "Loading graphics");
+	debugC(kDebugIO, "Loading graphics");
+	// ResourceManager reads the graphics file without reporting how many
+	// tiles it holds, so _graphic keeps the hand-off slots only: sizing it
+	// to the adventure waits on ResourceManager exposing that count.
 	_resourceManager->loadGraphics();
+	_mapView.invalidate();
 }
 
 Common::String AckEngine::getParameter(int idx) {
@@ -18,6 +18,8 @@
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/array.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/memstream.h"
 #include "common/rect.h"
 #include "common/textconsole.h"
@@ -27,6 +29,13 @@
 #include "graphics/surface.h"
 #include "graphics/palette.h"
 
+#include "engines/ack/arena.h"
+#include "engines/ack/formats.h"
+#include "engines/ack/hittest.h"
+#include "engines/ack/mapview.h"
+#include "engines/ack/jobs.h"
+#include "engines/ack/tiles.h"
+
 namespace Ack {
 
 // Type alias for strings.
@@ -39,27 +48,52 @@ struct SwapInfoRec {
 	byte data[11];
 };
 
-// 16x16 graphic tile structure (converted from Pascal type).
-struct Grap256Unit {
-	byte data[17][17];
-};
-
-typedef Grap256Unit GrapArray256;
-
 // Palette record.
 struct PaletteRec {
 	byte r, g, b;
 };
 
-// Master record for game configuration data.
-struct MasterRec {
-	byte textColors[10];
-	int ackVersion;
-	byte phaseColors[3][5][4];
+// Palette scaled to 8 bits per channel, ready for setPalette().
+struct PaletteData {
+	byte rgb[256 * 3];
+};
+
+// One main menu option as laid out on screen.
+struct MenuOption {
+	int iconCol, row;
+	int icon;
+	int textCol;
+	const char *labels[2];
+	bool enabled;
+	Common::Rect bounds;
+};
+
+// Stages of a staged adventure load, in the order they run.
+enum LoadStage {
+	kLoadStageIdle = 0,
+	kLoadStageConfig,
+	kLoadStageHandoff,
+	kLoadStageFont,
+	kLoadStageGraphics,
+	kLoadStageCount = kLoadStageGraphics
+};
+
+// Registration state as the original menu distinguishes it.
+enum Registration {
+	kRegistrationFull = 0,
+	kRegistrationNone
 };
 
 // Forward declaration for game description structure.
 struct AckGameDescription;
+class InputRecorder;
+class PackArchive;
+class Profiler;
+class ResourceCache;
+class SnapshotStore;
+struct IconSetResource;
+template<class T> class ResourceHandle;
+class TextRenderer;
 
 // Main ACK engine class.
 class AckEngine : public Engine {
@@ -69,32 +103,75 @@ public:
 
 	Common::Error run() override;
 
+	bool hasFeature(EngineFeature f) const override;
+	bool canLoadGameStateCurrently(Common::U32String *msg = nullptr) override;
+	bool canSaveGameStateCurrently(Common::U32String *msg = nullptr) override;
+	Common::Error loadGameState(int slot) override;
+	Common::Error saveGameState(int slot, const Common::String &desc, bool isAutosave = false) override;
+	Common::String getSaveStateName(int slot) const override;
+
+	Profiler *getProfiler() const { return _profiler; }
+
+	// Bundles the current adventure's data files into a pack save file.
+	bool writeDataPack(const Common::String &packName, bool compress);
+
 private:
+	friend class Benchmark;
+
+	// Constants.
+	static const int kBlockSize = 10;
+	static const int kGrapsSize = 10;
+	static const int kPalette = 0;
+	static const int kAckVersion = 20;
+	static const int kScreenWidth = 320;
+	static const int kScreenHeight = 200;
+	static const int kMaxIcons = kIconSetSize;
+	static const int kMaxGraphics = 255;
+	static const uint kMaxDirtyRects = 16;
+	static const int kMenuOptions = 12;
+	// Tiles the play screen shows above its 8-pixel status line.
+	static const int kMapCols = kScreenWidth / kTileSize;
+	static const int kMapRows = (kScreenHeight - 8) / kTileSize;
+
 	// Private member variables.
 	bool _quitTime;
 	SwapInfoRec *_swapInfo;
 	char _menuCmd;
-	Common::String _daughter;
-	Common::String _ds, _dc, _hres;
-	GrapArray256 *_icons;
+	char _daughter[64];
+	char _ds[4], _dc[16];
+	char _hres[kTileSize];
+	uint32 _daughterAdvGeneration;
+	Tile *_icons;
+	Common::String _iconCacheName;
+
+	// The icon file as saveIcons() last wrote it, and the tiles edited since.
+	Common::Array<byte> _iconImage;
+	Common::String _iconImageName;
+	bool _iconDirty[kMaxIcons + 1];
 	int16 _whatOpt;
 	int16 _oldWhatOpt;
 	int _i, _i1, _i2;
 	Common::String _systemDir;
 	bool _passwordOk;
-	Common::String _registration;
+	Registration _registration;
 	Common::String _regno;
-	MasterRec _ack;
+	MasterRec *_ack; // In the adventure arena.
 	SwapInfoRec *_p4ts;
 	bool _checking;
 	byte *_block;
 	Common::String _bgiDir;
 	bool _disableMouse;
-	Grap256Unit *_graphic;
+	TileStore _graphic;
 	Common::String _advName;
+	bool _advLoaded; // False while _advName is the "NONAME" placeholder.
+	uint32 _advGeneration; // Bumped whenever _advName changes.
 	Common::String _lastCfgLoad;
 	int _doserror;
 	int _dosexitcode;
+	uint32 _tickMillis;
+	uint32 _tickCount;
+	bool _overlayShown;
+	LoadStage _loadStage;
 
 	// Mouse state.
 	bool _mouseOn;
@@ -102,21 +179,44 @@ private:
 	int _mouseX, _mouseY;
 	bool _mouseClicked;
 
-	// Screen memory.
+	// Screen memory. _screenBuffer points at the pixels of _surface.
 	Graphics::Surface *_surface;
 	byte *_screenBuffer;
 	int _scrnl;
-	int _scrnh[40];
+	int _scrnh[kScreenHeight];
 	bool _spaceMono;
 
-	// Constants.
-	static const int kBlockSize = 10;
-	static const int kGrapsSize = 10;
-	static const int kPalette = 0;
-	static const int kAckVersion = 20;
-	static const int kScreenWidth = 320;
-	static const int kScreenHeight = 200;
-	static const int kMaxIcons = 100;
+	// Palette last sent to the backend.
+	byte _currentPalette[256 * 3];
+	bool _paletteValid;
+
+	// Main menu model, indexed like _whatOpt, and the state it was built for.
+	MenuOption _menuOptions[kMenuOptions + 1];
+	Common::String _menuTitle, _menuSubtitle;
+	uint32 _menuAdvGeneration;
+	bool _menuAdvLoaded;
+	Registration _menuRegistration;
+	bool _menuPasswordOk;
+	bool _menuValid;
+	HitTestGrid _menuHitGrid;
+	int _hoverOpt;
+
+	// Screen areas drawn since the last present; fixed storage so marking and
+	// presenting never touch the heap.
+	Common::Rect _dirtyRects[kMaxDirtyRects + 1];
+	uint _dirtyCount;
+
+	// Framebuffer addressing. These assert that the requested pixel or block
+	// lies on screen; the checks compile away in release builds.
+	byte *screenPixel(int x, int y) {
+		assert(x >= 0 && x < kScreenWidth && y >= 0 && y < kScreenHeight);
+		return _screenBuffer + _scrnh[y] + x;
+	}
+	byte *screenBlock(int x, int y, int w, int h) {
+		assert(x >= 0 && w >= 0 && x + w <= kScreenWidth);
+		assert(y >= 0 && h >= 0 && y + h <= kScreenHeight);
+		return _screenBuffer + _scrnh[y] + x;
+	}
 
 	// Method declarations.
 	void initVars();
@@ -124,21 +224,43 @@ private:
 	Common::Error allocateResources();
 	void initGameState();
 	void processParameters();
+	void runAdventureLoad();
+	void stepAdventureLoad();
+	void drawLoadProgress();
 	void loadBmpPalette(int version, const Common::String &name, const Common::String &sysdir);
-	void menuSkinBmp();
+	bool loadMenuSkin(Graphics::Surface &skin);
+	void applyPalette(const byte *palData);
+	void menuSkinBmp(const Common::Rect &area = Common::Rect(kScreenWidth, kScreenHeight));
+	void markDirty(const Common::Rect &r);
 	void updateScreen();
+	void drawProfileOverlay();
 	Common::String version(byte v);
+	bool resetAdventureArena();
 	void loadConfig();
+	void setAdventure(const Common::String &name);
+	void clearAdventure();
+	void invalidateConfig();
+	Common::String packMember(const Common::String &path) const;
+	bool dataFileExists(const Common::String &path) const;
+	bool openDataFile(Common::File &file, const Common::String &path);
 	void loadIcons(const Common::String &fn);
+	void prefetchIcons(const Common::String &fn);
 	void saveIcons(const Common::String &fn);
+	void iconChanged(int i);
 	void putIcon(int xb, int yy, int bb);
+	void drawMap();
+	bool menuStateChanged() const;
+	void buildMenu();
 	void showOption(byte x, byte n, int16 mo);
 	void redisplay();
 	void checkRegistration();
 	void displayText(int x, int y, int color, const Common::String &text);
 	void clearScreen();
+	void buildDaughterCommand();
+	void waitForNextTick(uint32 tickStart);
 	void mainMenuLoop();
 	bool handleEvents();
+	bool nextEvent(Common::Event &event, char &key);
 	void checkMouseClick();
 	void checkMouseMenuRegions();
 	bool mouseIn(int x1, int y1, int x2, int y2);
@@ -146,6 +268,8 @@ private:
 	void handleAdventureSelection();
 	void handleAdventurePlay();
 	bool loadAdventure(const Common::String &name);
+	void captureState(Common::Array<byte> &state) const;
+	bool restoreState(const Common::Array<byte> &state);
 	char convertKeyCode(Common::KeyCode keycode);
 	void initMouse();
 	void showMouse();
@@ -156,7 +280,30 @@ private:
 	void loadGraps();
 	Common::String getParameter(int idx);
 
+	// The framebuffer, system icons and swap records live in the system
+	// arena for the engine's lifetime. Everything specific to the loaded
+	// adventure lives in the adventure arena, replaced wholesale on load.
+	Arena _systemArena;
+	Arena _advArena;
+
+	// Play screen map, above an 8-pixel status line.
+	MapView _mapView;
+
+	// Decoding worked on between ticks, and the icon set it last prefetched,
+	// held so the cache cannot evict it before loadIcons() takes it.
+	JobQueue _jobs;
+	ResourceHandle<IconSetResource> *_prefetchedIcons;
+
+	// Save game payloads, and the state image reused by every save.
+	SnapshotStore *_snapshots;
+	Common::Array<byte> _state;
+
 	// Manager object references.
+	InputRecorder *_inputRecorder;
+	PackArchive *_pack; // Owned by SearchMan.
+	Profiler *_profiler;
+	ResourceCache *_cache;
+	TextRenderer *_textRenderer;
 	GraphicsManager *_graphicsManager;
 	SoundManager *_soundManager;
 	ScriptManager *_scriptManager;
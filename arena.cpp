@@ -0,0 +1,51 @@
+/* ScummVM - ACK Engine Arenas
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/arena.h"
+
+#include "common/util.h"
+
+namespace Ack {
+
+Arena::Arena() : _block(nullptr), _capacity(0), _used(0) {
+}
+
+Arena::~Arena() {
+	release();
+}
+
+bool Arena::reserve(uint32 capacity) {
+	release();
+
+	// Over-allocate so the usable block can start on an aligned address.
+	_block = (byte *)malloc(capacity + kAlignment);
+	if (!_block)
+		return false;
+	_capacity = capacity;
+	return true;
+}
+
+void Arena::release() {
+	free(_block);
+	_block = nullptr;
+	_capacity = 0;
+	_used = 0;
+}
+
+void *Arena::allocate(uint32 size, uint32 alignment) {
+	if (!_block)
+		return nullptr;
+
+	byte *base = (byte *)(((uintptr)_block + kAlignment - 1) & ~(uintptr)(kAlignment - 1));
+	uint32 start = (_used + alignment - 1) & ~(alignment - 1);
+	if (start > _capacity || size > _capacity - start)
+		return nullptr;
+
+	_used = start + size;
+	memset(base + start, 0, size);
+	return base + start;
+}
+
+} // End of namespace Ack
@@ -0,0 +1,55 @@
+/* ScummVM - ACK Engine Arenas
+ *
+ * A bump allocator over one contiguous block. Everything carved from an
+ * arena is released together, so an adventure's data costs one allocation
+ * to load and one free to unload whatever its shape.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_ARENA_H
+#define ACK_ARENA_H
+
+#include "common/scummsys.h"
+
+namespace Ack {
+
+class Arena {
+public:
+	static const uint32 kAlignment = 16;
+
+	Arena();
+	~Arena();
+
+	// Replaces the block with a fresh one of capacity bytes, dropping
+	// everything allocated from the old one.
+	bool reserve(uint32 capacity);
+	void release();
+
+	// Drops every allocation but keeps the block.
+	void rewind() { _used = 0; }
+
+	// Returns zero-filled memory, or nullptr once the block is exhausted.
+	// Nothing is ever freed individually and no destructors run.
+	void *allocate(uint32 size, uint32 alignment = kAlignment);
+
+	template<class T>
+	T *allocate(uint32 count = 1) {
+		return static_cast<T *>(allocate(count * sizeof(T), alignof(T) > kAlignment ? alignof(T) : kAlignment));
+	}
+
+	uint32 getUsed() const { return _used; }
+	uint32 getCapacity() const { return _capacity; }
+
+	// Bytes an allocation of size takes up, padding included.
+	static uint32 footprint(uint32 size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+private:
+	byte *_block;
+	uint32 _capacity;
+	uint32 _used;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_ARENA_H
@@ -0,0 +1,287 @@
+/* ScummVM - ACK Engine Benchmark
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/benchmark.h"
+#include "engines/ack/ack.h"
+#include "engines/ack/blit.h"
+#include "engines/ack/cache.h"
+#include "engines/ack/profiler.h"
+#include "engines/ack/saveindex.h"
+
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/savefile.h"
+
+namespace Ack {
+
+// Save target used to fabricate save slots for the save list scenario.
+static const char *const kBenchTarget = "ack-bench";
+static const char *const kBenchIcons = "ACKBENCH.ICO";
+
+Benchmark::Benchmark(AckEngine *vm) : _vm(vm), _opStart(0), _opResourceAllocs(0) {
+}
+
+void Benchmark::begin(Samples &samples, const char *name, int iterations) {
+	samples.name = name;
+	samples.millis.clear();
+	samples.millis.reserve(iterations);
+	samples.resourceAllocs = 0;
+}
+
+void Benchmark::beginOp() {
+	_opResourceAllocs = _vm->_profiler->getTotal(kCounterResourceAllocs);
+	_opStart = g_system->getMillis();
+}
+
+void Benchmark::endOp(Samples &samples) {
+	samples.millis.push_back(g_system->getMillis() - _opStart);
+	samples.resourceAllocs += _vm->_profiler->getTotal(kCounterResourceAllocs) - _opResourceAllocs;
+}
+
+void Benchmark::report(Common::String &out, Samples &samples) const {
+	uint n = samples.millis.size();
+	if (!n)
+		return;
+
+	Common::sort(samples.millis.begin(), samples.millis.end());
+	uint32 total = 0;
+	for (uint i = 0; i < n; i++)
+		total += samples.millis[i];
+
+	// Individual timings only have millisecond resolution, so the mean is
+	// taken over the whole run to resolve operations faster than that.
+	out += Common::String::format("%-20s n=%-5u mean=%7uus p50=%3ums p90=%3ums p99=%3ums max=%3ums res-allocs/op=%u.%02u\n",
+	                              samples.name, n, total * 1000 / n,
+	                              samples.millis[n / 2], samples.millis[n * 9 / 10],
+	                              samples.millis[n * 99 / 100], samples.millis[n - 1],
+	                              samples.resourceAllocs / n, samples.resourceAllocs * 100 / n % 100);
+}
+
+Common::String Benchmark::run(int iterations) {
+	Common::String out = Common::String::format("ACK benchmark, %d iterations\n", iterations);
+	out += "res-allocs counts resources, buffers and files the engine creates, not heap allocations\n";
+	benchRedisplay(out, iterations);
+	benchHighlight(out, iterations);
+	benchIcons(out, iterations);
+	benchBlit(out, iterations);
+	benchAdventure(out, iterations);
+	benchSaveList(out, iterations);
+
+	// Leave the menu as the scenarios found it.
+	_vm->_menuValid = false;
+	_vm->redisplay();
+	_vm->updateScreen();
+	return out;
+}
+
+void Benchmark::benchRedisplay(Common::String &out, int iterations) {
+	Samples warm, cold;
+	begin(warm, "redisplay", iterations);
+	begin(cold, "redisplay (rebuild)", iterations);
+
+	for (int i = 0; i < iterations; i++) {
+		beginOp();
+		_vm->redisplay();
+		_vm->updateScreen();
+		endOp(warm);
+
+		_vm->_menuValid = false;
+		beginOp();
+		_vm->redisplay();
+		_vm->updateScreen();
+		endOp(cold);
+	}
+
+	report(out, warm);
+	report(out, cold);
+}
+
+void Benchmark::benchHighlight(Common::String &out, int iterations) {
+	Samples samples;
+	begin(samples, "highlight change", iterations);
+
+	int opt = _vm->_whatOpt;
+	for (int i = 0; i < iterations; i++) {
+		int next = opt % AckEngine::kMenuOptions + 1;
+		beginOp();
+		_vm->showOption(opt, 0, 1);
+		_vm->showOption(next, 6, -2);
+		_vm->updateScreen();
+		endOp(samples);
+		opt = next;
+	}
+	_vm->showOption(opt, 0, 1);
+
+	report(out, samples);
+}
+
+void Benchmark::benchIcons(Common::String &out, int iterations) {
+	Samples samples;
+	begin(samples, "icon save+load", iterations);
+
+	for (int i = 0; i < iterations; i++) {
+		beginOp();
+		_vm->saveIcons(kBenchIcons);
+		_vm->_cache->invalidate(kResourceIconSet, "ACKDATA1.ICO");
+		_vm->_iconCacheName.clear();
+		_vm->loadIcons("ACKDATA1.ICO");
+		endOp(samples);
+	}
+
+	report(out, samples);
+	checkIconRoundTrip(out);
+
+	_vm->_cache->invalidate(kResourceIconSet, kBenchIcons);
+	g_system->getSaveFileManager()->removeSavefile(_vm->_systemDir + kBenchIcons);
+}
+
+void Benchmark::checkIconRoundTrip(Common::String &out) {
+	// Loading, showing and saving the icons must give back the file's bytes.
+	const uint32 size = AckEngine::kMaxIcons * sizeof(Grap256Unit);
+	Common::Array<byte> original, saved;
+	original.resize(size);
+	saved.resize(size);
+
+	Common::File in;
+	if (!_vm->openDataFile(in, _vm->_systemDir + "ACKDATA1.ICO") || in.read(&original[0], size) != size) {
+		out += "icon round trip      skipped, ACKDATA1.ICO unreadable\n";
+		return;
+	}
+	in.close();
+
+	_vm->_cache->invalidate(kResourceIconSet, "ACKDATA1.ICO");
+	_vm->_iconCacheName.clear();
+	_vm->loadIcons("ACKDATA1.ICO");
+	_vm->redisplay();
+	_vm->saveIcons(kBenchIcons);
+
+	Common::InSaveFile *back = g_system->getSaveFileManager()->openForLoading(_vm->_systemDir + kBenchIcons);
+	bool same = back && back->read(&saved[0], size) == size && !memcmp(&original[0], &saved[0], size);
+	delete back;
+	out += same ? "icon round trip      ok\n" : "icon round trip      MISMATCH\n";
+}
+
+void Benchmark::benchBlit(Common::String &out, int iterations) {
+	// An op covers the map viewport with one tile a number of times over, so
+	// the kernels register on a millisecond clock.
+	static const int kPasses = 50;
+	static const int kPitch = AckEngine::kScreenWidth;
+
+	Samples generic, fixed, genericKeyed, simdKeyed, fixedKeyed;
+	begin(generic, "blit generic", iterations);
+	begin(fixed, "blit fixed", iterations);
+	begin(genericKeyed, "blit keyed generic", iterations);
+	begin(simdKeyed, "blit keyed simd", iterations);
+	begin(fixedKeyed, "blit keyed fixed", iterations);
+
+	byte *screen = _vm->_screenBuffer;
+	const Tile &tile = _vm->_icons[1];
+	const byte *src = &tile.pixels[0][0];
+
+#define ACK_BENCH_BLIT(samples, blit) \
+	beginOp(); \
+	for (int p = 0; p < kPasses; p++) { \
+		for (int row = 0; row < AckEngine::kMapRows; row++) { \
+			for (int col = 0; col < AckEngine::kMapCols; col++) { \
+				byte *dst = screen + row * kTileSize * kPitch + col * kTileSize; \
+				blit; \
+			} \
+		} \
+	} \
+	endOp(samples)
+
+	for (int i = 0; i < iterations; i++) {
+		ACK_BENCH_BLIT(generic, blitTile(dst, kPitch, tile));
+		ACK_BENCH_BLIT(fixed, blitTileFixed<kPitch>(dst, tile));
+		ACK_BENCH_BLIT(genericKeyed, blitKeyed(dst, kPitch, src, kTileSize, kTileSize, kTileSize, kTransparentColor));
+		ACK_BENCH_BLIT(simdKeyed, blitTileKeyed(dst, kPitch, tile, kTransparentColor));
+		ACK_BENCH_BLIT(fixedKeyed, (blitTileFixed<kPitch, kBlitKeyed>(dst, tile)));
+	}
+
+#undef ACK_BENCH_BLIT
+
+	report(out, generic);
+	report(out, fixed);
+	report(out, genericKeyed);
+	report(out, simdKeyed);
+	report(out, fixedKeyed);
+}
+
+void Benchmark::benchAdventure(Common::String &out, int iterations) {
+	Common::String name = ConfMan.get("benchmark_adventure");
+	if (name.empty()) {
+		out += "loadAdventure        skipped, set benchmark_adventure\n";
+		return;
+	}
+
+	Samples samples;
+	begin(samples, "loadAdventure", iterations);
+
+	// Loading replaces the adventure, its tiles and the palette, so all of
+	// it is put back afterwards the way a saved game would be.
+	Common::Array<byte> state;
+	_vm->captureState(state);
+	byte palette[sizeof(_vm->_currentPalette)];
+	memcpy(palette, _vm->_currentPalette, sizeof(palette));
+
+	for (int i = 0; i < iterations; i++) {
+		_vm->setAdventure(name);
+		_vm->_cache->invalidate(kResourceMaster, name + "MASTER.DAT");
+		beginOp();
+		_vm->loadAdventure(name);
+		endOp(samples);
+	}
+
+	if (!_vm->restoreState(state))
+		warning("Could not restore the adventure after the benchmark");
+	_vm->applyPalette(palette);
+
+	report(out, samples);
+}
+
+void Benchmark::benchSaveList(Common::String &out, int iterations) {
+	Common::SaveFileManager *saveFileMan = g_system->getSaveFileManager();
+	Common::String indexName = Common::String(kBenchTarget) + ".idx";
+
+	// Fabricate a full set of slots with the header the real saves carry.
+	for (int slot = 0; slot <= 99; slot++) {
+		Common::OutSaveFile *save = saveFileMan->openForSaving(Common::String::format("%s.%02d", kBenchTarget, slot), false);
+		if (!save)
+			return;
+		save->writeString(Common::String::format("Benchmark slot %d", slot));
+		save->writeByte(0);
+		for (int field = 0; field < 5; field++)
+			save->writeSint16LE(1);
+		save->writeUint32LE(0);
+		save->writeByte(0);
+		save->finalize();
+		delete save;
+	}
+
+	Samples cold, warm;
+	begin(cold, "listSaves (scan)", iterations);
+	begin(warm, "listSaves (index)", iterations);
+	Common::String pattern = Common::String(kBenchTarget) + ".??";
+
+	for (int i = 0; i < iterations; i++) {
+		saveFileMan->removeSavefile(indexName);
+		beginOp();
+		SaveIndex(kBenchTarget).refresh(saveFileMan->listSavefiles(pattern));
+		endOp(cold);
+
+		beginOp();
+		SaveIndex(kBenchTarget).refresh(saveFileMan->listSavefiles(pattern));
+		endOp(warm);
+	}
+
+	for (int slot = 0; slot <= 99; slot++)
+		saveFileMan->removeSavefile(Common::String::format("%s.%02d", kBenchTarget, slot));
+	saveFileMan->removeSavefile(indexName);
+
+	report(out, cold);
+	report(out, warm);
+}
+
+} // End of namespace Ack
@@ -0,0 +1,56 @@
+/* ScummVM - ACK Engine Benchmark
+ *
+ * Replays fixed scenarios against the rendering and loading paths and
+ * reports per-operation latency percentiles. Runs from the debugger or,
+ * with the "benchmark" config key set, headless in place of the menu,
+ * which together with the null backend needs no display at all.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_BENCHMARK_H
+#define ACK_BENCHMARK_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/str.h"
+
+namespace Ack {
+
+class AckEngine;
+
+class Benchmark {
+public:
+	explicit Benchmark(AckEngine *vm);
+
+	// Runs every scenario the given number of times and returns the report.
+	Common::String run(int iterations);
+
+private:
+	struct Samples {
+		const char *name;
+		Common::Array<uint32> millis;
+		uint32 resourceAllocs;
+	};
+
+	void begin(Samples &samples, const char *name, int iterations);
+	void beginOp();
+	void endOp(Samples &samples);
+	void report(Common::String &out, Samples &samples) const;
+
+	void benchRedisplay(Common::String &out, int iterations);
+	void benchHighlight(Common::String &out, int iterations);
+	void benchIcons(Common::String &out, int iterations);
+	void checkIconRoundTrip(Common::String &out);
+	void benchBlit(Common::String &out, int iterations);
+	void benchAdventure(Common::String &out, int iterations);
+	void benchSaveList(Common::String &out, int iterations);
+
+	AckEngine *_vm;
+	uint32 _opStart;
+	uint32 _opResourceAllocs;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_BENCHMARK_H
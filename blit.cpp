@@ -0,0 +1,64 @@
+/* ScummVM - ACK Engine Blitters
+ *
+ * Scalar, SSE2 and NEON implementations of the tile blitting kernels. The
+ * vector path is chosen at compile time from the target's baseline ISA.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/blit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ACK_BLIT_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ACK_BLIT_NEON
+#endif
+
+namespace Ack {
+
+void blitTile(byte *dst, int pitch, const Tile &tile) {
+	for (int i = 0; i < kTileSize; i++, dst += pitch)
+		memcpy(dst, tile.pixels[i], kTileSize);
+}
+
+void blitTileKeyed(byte *dst, int pitch, const Tile &tile, byte key) {
+#if defined(ACK_BLIT_SSE2)
+	const __m128i keyv = _mm_set1_epi8((char)key);
+	for (int i = 0; i < kTileSize; i++, dst += pitch) {
+		// Tiles in heap-backed stores may miss their declared alignment.
+		const __m128i src = _mm_loadu_si128((const __m128i *)tile.pixels[i]);
+		const __m128i old = _mm_loadu_si128((const __m128i *)dst);
+		const __m128i mask = _mm_cmpeq_epi8(src, keyv);
+		_mm_storeu_si128((__m128i *)dst,
+		                 _mm_or_si128(_mm_and_si128(mask, old), _mm_andnot_si128(mask, src)));
+	}
+#elif defined(ACK_BLIT_NEON)
+	const uint8x16_t keyv = vdupq_n_u8(key);
+	for (int i = 0; i < kTileSize; i++, dst += pitch) {
+		const uint8x16_t src = vld1q_u8(tile.pixels[i]);
+		const uint8x16_t old = vld1q_u8(dst);
+		vst1q_u8(dst, vbslq_u8(vceqq_u8(src, keyv), old, src));
+	}
+#else
+	for (int i = 0; i < kTileSize; i++, dst += pitch) {
+		const byte *src = tile.pixels[i];
+		for (int j = 0; j < kTileSize; j++) {
+			if (src[j] != key)
+				dst[j] = src[j];
+		}
+	}
+#endif
+}
+
+void blitKeyed(byte *dst, int dstPitch, const byte *src, int srcPitch, int w, int h, byte key) {
+	for (int i = 0; i < h; i++, dst += dstPitch, src += srcPitch) {
+		for (int j = 0; j < w; j++) {
+			if (src[j] != key)
+				dst[j] = src[j];
+		}
+	}
+}
+
+} // End of namespace Ack
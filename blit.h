@@ -0,0 +1,60 @@
+/* ScummVM - ACK Engine Blitters
+ *
+ * Tile blitting kernels shared by the menu, the editors and the map view.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_BLIT_H
+#define ACK_BLIT_H
+
+#include "engines/ack/tiles.h"
+
+namespace Ack {
+
+// Palette index treated as transparent in icon and graphic tiles.
+static const byte kTransparentColor = 222;
+
+// Copies a 16x16 tile to dst, row by row.
+void blitTile(byte *dst, int pitch, const Tile &tile);
+
+// Copies a 16x16 tile to dst, leaving dst untouched wherever the tile holds
+// the key color. Each row is compared and stored 16 pixels at a time.
+void blitTileKeyed(byte *dst, int pitch, const Tile &tile, byte key);
+
+// Copies a w x h block to dst, skipping source pixels that hold the key.
+void blitKeyed(byte *dst, int dstPitch, const byte *src, int srcPitch, int w, int h, byte key);
+
+enum BlitMode {
+	kBlitOpaque,
+	kBlitKeyed
+};
+
+// Copies a W x H block, fixed at compile time so the compiler can unroll
+// and vectorize it. A pitch given as a template argument overrides the
+// runtime one; leave it 0 for buffers whose pitch varies. Keyed blits leave
+// dst untouched where the source holds key.
+template<int W, int H, BlitMode Mode, int DstPitch = 0, int SrcPitch = 0>
+inline void blitFixed(byte *dst, int dstPitch, const byte *src, int srcPitch, byte key = 0) {
+	const int dp = DstPitch ? DstPitch : dstPitch;
+	const int sp = SrcPitch ? SrcPitch : srcPitch;
+	for (int i = 0; i < H; i++, dst += dp, src += sp) {
+		if (Mode == kBlitOpaque) {
+			memcpy(dst, src, W);
+		} else {
+			// A select rather than a branch, which vectorizes.
+			for (int j = 0; j < W; j++)
+				dst[j] = (src[j] == key) ? dst[j] : src[j];
+		}
+	}
+}
+
+// A whole tile onto a buffer of fixed pitch, such as the screen.
+template<int DstPitch, BlitMode Mode = kBlitOpaque>
+inline void blitTileFixed(byte *dst, const Tile &tile, byte key = kTransparentColor) {
+	blitFixed<kTileSize, kTileSize, Mode, DstPitch, kTileSize>(dst, DstPitch, &tile.pixels[0][0], kTileSize, key);
+}
+
+} // End of namespace Ack
+
+#endif // ACK_BLIT_H
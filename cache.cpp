@@ -0,0 +1,101 @@
+/* ScummVM - ACK Engine Resource Cache
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/cache.h"
+#include "engines/ack/detection.h"
+
+#include "common/debug.h"
+
+namespace Ack {
+
+ResourceCache::ResourceCache(uint32 budget) : _budget(budget), _used(0), _clock(0) {
+}
+
+ResourceCache::~ResourceCache() {
+	clear();
+}
+
+CachedResource *ResourceCache::lookup(ResourceType type, const Common::String &name) {
+	Key key;
+	key.type = type;
+	key.name = name;
+
+	EntryMap::iterator it = _entries.find(key);
+	if (it == _entries.end())
+		return nullptr;
+
+	it->_value.lastUse = ++_clock;
+	return it->_value.res;
+}
+
+void ResourceCache::insert(ResourceType type, const Common::String &name, CachedResource *res) {
+	Key key;
+	key.type = type;
+	key.name = name;
+
+	EntryMap::iterator it = _entries.find(key);
+	if (it != _entries.end())
+		drop(it);
+
+	Entry entry;
+	entry.res = res;
+	entry.size = res->memorySize();
+	entry.lastUse = ++_clock;
+	_entries[key] = entry;
+	_used += entry.size;
+
+	evict();
+}
+
+void ResourceCache::drop(EntryMap::iterator it) {
+	CachedResource *res = it->_value.res;
+	_used -= it->_value.size;
+	_entries.erase(it);
+
+	if (res->_refCount == 0)
+		delete res;
+	else
+		res->_orphaned = true;
+}
+
+void ResourceCache::invalidate(ResourceType type, const Common::String &name) {
+	Key key;
+	key.type = type;
+	key.name = name;
+
+	EntryMap::iterator it = _entries.find(key);
+	if (it != _entries.end())
+		drop(it);
+}
+
+void ResourceCache::clear() {
+	while (!_entries.empty())
+		drop(_entries.begin());
+}
+
+void ResourceCache::setBudget(uint32 budget) {
+	_budget = budget;
+	evict();
+}
+
+void ResourceCache::evict() {
+	// Drop unreferenced entries, oldest first, until the cache fits. What is
+	// still referenced stays, even if that keeps the cache over budget.
+	while (_used > _budget) {
+		EntryMap::iterator victim = _entries.end();
+		for (EntryMap::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+			if (it->_value.res->_refCount == 0 &&
+			    (victim == _entries.end() || it->_value.lastUse < victim->_value.lastUse))
+				victim = it;
+		}
+		if (victim == _entries.end())
+			break;
+
+		debugC(kDebugIO, "Evicting cached resource %s", victim->_key.name.c_str());
+		drop(victim);
+	}
+}
+
+} // End of namespace Ack
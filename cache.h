@@ -0,0 +1,174 @@
+/* ScummVM - ACK Engine Resource Cache
+ *
+ * Keeps decoded engine resources resident between uses, within a memory
+ * budget. Resources are reference counted through typed handles, and the
+ * least recently used unreferenced ones are evicted first.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_CACHE_H
+#define ACK_CACHE_H
+
+#include "engines/ack/ack.h"
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+namespace Ack {
+
+enum ResourceType {
+	kResourcePalette,
+	kResourceIconSet,
+	kResourceSkin,
+	kResourceMaster
+};
+
+class ResourceCache;
+
+// Base class of everything the cache can hold.
+class CachedResource {
+public:
+	CachedResource() : _refCount(0), _orphaned(false) {}
+	virtual ~CachedResource() {}
+
+	// Approximate heap footprint, charged against the cache budget.
+	virtual uint32 memorySize() const = 0;
+
+private:
+	friend class ResourceCache;
+	template<class T> friend class ResourceHandle;
+
+	int _refCount;  // Handles alive outside the cache.
+	bool _orphaned; // Dropped from the cache while still referenced.
+};
+
+// Reference to a cached resource. A referenced resource is never evicted;
+// one dropped from the cache while referenced lives until its last handle.
+template<class T>
+class ResourceHandle {
+public:
+	ResourceHandle() : _res(nullptr) {}
+	explicit ResourceHandle(T *res) : _res(res) { acquire(); }
+	ResourceHandle(const ResourceHandle &other) : _res(other._res) { acquire(); }
+	~ResourceHandle() { release(); }
+
+	ResourceHandle &operator=(const ResourceHandle &other) {
+		if (_res != other._res) {
+			release();
+			_res = other._res;
+			acquire();
+		}
+		return *this;
+	}
+
+	T *get() const { return _res; }
+	T *operator->() const { return _res; }
+	T &operator*() const { return *_res; }
+	bool isValid() const { return _res != nullptr; }
+	void reset() { release(); }
+
+private:
+	void acquire() {
+		if (_res)
+			_res->_refCount++;
+	}
+	void release() {
+		if (_res && --_res->_refCount == 0 && _res->_orphaned)
+			delete _res;
+		_res = nullptr;
+	}
+
+	T *_res;
+};
+
+struct PaletteResource : public CachedResource {
+	static const ResourceType kType = kResourcePalette;
+	PaletteData palette;
+	uint32 memorySize() const override { return sizeof(*this); }
+};
+
+struct IconSetResource : public CachedResource {
+	static const ResourceType kType = kResourceIconSet;
+	Tile tiles[kIconSetSize + 1];
+	uint32 memorySize() const override { return sizeof(*this); }
+};
+
+struct SkinResource : public CachedResource {
+	static const ResourceType kType = kResourceSkin;
+	Graphics::Surface surface;
+	~SkinResource() override { surface.free(); }
+	uint32 memorySize() const override { return sizeof(*this) + surface.pitch * surface.h; }
+};
+
+struct MasterResource : public CachedResource {
+	static const ResourceType kType = kResourceMaster;
+	MasterRec master;
+	uint32 memorySize() const override { return sizeof(*this); }
+};
+
+class ResourceCache {
+public:
+	explicit ResourceCache(uint32 budget);
+	~ResourceCache();
+
+	// Returns the cached resource of type T under name, or an invalid handle.
+	template<class T>
+	ResourceHandle<T> get(const Common::String &name) {
+		return ResourceHandle<T>(static_cast<T *>(lookup(T::kType, name)));
+	}
+
+	// Takes ownership of res and files it under name, replacing any resource
+	// already there.
+	template<class T>
+	ResourceHandle<T> put(const Common::String &name, T *res) {
+		ResourceHandle<T> handle(res);
+		insert(T::kType, name, res);
+		return handle;
+	}
+
+	void invalidate(ResourceType type, const Common::String &name);
+	void clear();
+
+	void setBudget(uint32 budget);
+	uint32 getBudget() const { return _budget; }
+	uint32 getMemoryUsed() const { return _used; }
+
+private:
+	struct Key {
+		ResourceType type;
+		Common::String name;
+
+		bool operator==(const Key &other) const {
+			return type == other.type && name == other.name;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const {
+			return Common::hashit(key.name.c_str()) ^ (uint)key.type;
+		}
+	};
+
+	struct Entry {
+		CachedResource *res;
+		uint32 size;
+		uint32 lastUse;
+	};
+
+	typedef Common::HashMap<Key, Entry, KeyHash> EntryMap;
+
+	CachedResource *lookup(ResourceType type, const Common::String &name);
+	void insert(ResourceType type, const Common::String &name, CachedResource *res);
+	void drop(EntryMap::iterator it);
+	void evict();
+
+	EntryMap _entries;
+	uint32 _budget;
+	uint32 _used;
+	uint32 _clock;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_CACHE_H
@@ -0,0 +1,56 @@
+/* ScummVM - ACK Engine Debug Console
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/console.h"
+#include "engines/ack/ack.h"
+#include "engines/ack/benchmark.h"
+#include "engines/ack/profiler.h"
+
+namespace Ack {
+
+Console::Console(AckEngine *vm) : GUI::Debugger(), _vm(vm) {
+	registerCmd("stats", WRAP_METHOD(Console, cmdStats));
+	registerCmd("overlay", WRAP_METHOD(Console, cmdOverlay));
+	registerCmd("bench", WRAP_METHOD(Console, cmdBench));
+	registerCmd("pack", WRAP_METHOD(Console, cmdPack));
+}
+
+bool Console::cmdStats(int argc, const char **argv) {
+	Profiler *profiler = _vm->getProfiler();
+	debugPrintf("%s", profiler->getReport().c_str());
+	if (argc > 1 && !strcmp(argv[1], "reset"))
+		profiler->reset();
+	return true;
+}
+
+bool Console::cmdOverlay(int argc, const char **argv) {
+	Profiler *profiler = _vm->getProfiler();
+	if (argc > 1)
+		profiler->setOverlayEnabled(!strcmp(argv[1], "on"));
+	debugPrintf("Profiling overlay is %s\n", profiler->isOverlayEnabled() ? "on" : "off");
+	return true;
+}
+
+bool Console::cmdBench(int argc, const char **argv) {
+	int iterations = argc > 1 ? atoi(argv[1]) : 100;
+	if (iterations <= 0) {
+		debugPrintf("Usage: %s [iterations]\n", argv[0]);
+		return true;
+	}
+	debugPrintf("%s", Benchmark(_vm).run(iterations).c_str());
+	return true;
+}
+
+bool Console::cmdPack(int argc, const char **argv) {
+	bool compress = !(argc > 1 && !strcmp(argv[1], "nocompress"));
+	if (!_vm->writeDataPack("ACKDATA.ACK", compress)) {
+		debugPrintf("Could not write ACKDATA.ACK\n");
+		return true;
+	}
+	debugPrintf("Wrote ACKDATA.ACK to the save directory\n");
+	return true;
+}
+
+} // End of namespace Ack
@@ -0,0 +1,30 @@
+/* ScummVM - ACK Engine Debug Console
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_CONSOLE_H
+#define ACK_CONSOLE_H
+
+#include "gui/debugger.h"
+
+namespace Ack {
+
+class AckEngine;
+
+class Console : public GUI::Debugger {
+public:
+	explicit Console(AckEngine *vm);
+
+private:
+	bool cmdStats(int argc, const char **argv);
+	bool cmdOverlay(int argc, const char **argv);
+	bool cmdBench(int argc, const char **argv);
+	bool cmdPack(int argc, const char **argv);
+
+	AckEngine *_vm;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_CONSOLE_H
@@ -8,9 +8,13 @@
  */
 
 #include "engines/ack/detection.h"
-#include "engines/ack/ack.h"
+#include "engines/ack/formats.h"
 
 #include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/md5.h"
 #include "common/system.h"
 #include "common/savefile.h"
 #include "common/translation.h"
@@ -39,16 +43,10 @@ static const ADExtraGuiOptionsMap optionsList[] = {
 	AD_EXTRA_GUI_OPTIONS_TERMINATOR
 };
 
+// ACK data is user-made, so there are no known checksums to list; every
+// game is found by fallbackDetect(), which keeps the advanced detector from
+// hashing each ACKDATA0.DAT before the cached fallback path gets to it.
 static const AckGameDescription gameDescriptions[] = {
-	{
-		{
-			"ack",
-			"",
-			AD_ENTRY1("ACKDATA0.DAT", "12345678901234567890123456789012"),
-			/* Additional metadata fields as needed */
-		},
-		/* Additional structure fields as needed */
-	},
 	{nullptr, nullptr}  // Terminator
 };
 
@@ -60,4 +58,221 @@ const PlainGameDescriptor *detectGame(const Common::String &gameId) {
 	return nullptr;
 }
 
+// Only the head of each file is hashed; it holds the BMP header and palette,
+// which is enough to tell ACK data files apart.
+static const int kDetectionHashBytes = 5000;
+
+// ACK versions are stored as tens, V1.0 being 10.
+static const int kMinAckVersion = 10;
+static const int kMaxAckVersion = 99;
+
+// Persisted verdicts for ACKDATA0.DAT files already examined, keyed by path
+// and size. The filesystem API exposes no modification times, so a file
+// rewritten in place at the same size keeps its cached verdict. Only facts
+// about the skin itself are kept; the adventure beside it is read afresh,
+// since it may be edited or swapped without the skin changing.
+class DetectionCache {
+public:
+	struct Entry {
+		bool isAck;
+		Common::String md5;
+	};
+
+	DetectionCache() : _loaded(false), _dirty(false) {}
+
+	const Entry *find(const Common::String &key) {
+		load();
+		EntryMap::const_iterator it = _entries.find(key);
+		return it != _entries.end() ? &it->_value : nullptr;
+	}
+
+	void store(const Common::String &key, const Entry &entry) {
+		_entries[key] = entry;
+		_dirty = true;
+	}
+
+	void save();
+
+private:
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	void load();
+
+	EntryMap _entries;
+	bool _loaded;
+	bool _dirty;
+};
+
+static const char *const kDetectionCacheName = "ack-detect.cache";
+static const uint32 kDetectionCacheTag = MKTAG('A', 'C', 'K', 'D');
+static const uint16 kDetectionCacheVersion = 2;
+
+void DetectionCache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::InSaveFile *in = g_system->getSaveFileManager()->openForLoading(kDetectionCacheName);
+	if (!in)
+		return;
+
+	bool ok = in->readUint32BE() == kDetectionCacheTag && in->readUint16LE() == kDetectionCacheVersion;
+	uint32 count = ok ? in->readUint32LE() : 0;
+	for (uint32 i = 0; i < count && ok; i++) {
+		Common::String key = in->readString();
+		Entry entry;
+		entry.isAck = in->readByte() != 0;
+		entry.md5 = in->readString();
+		ok = !in->err() && !in->eos();
+		if (ok)
+			_entries[key] = entry;
+	}
+	delete in;
+
+	if (!ok)
+		_entries.clear();
+}
+
+void DetectionCache::save() {
+	if (!_dirty)
+		return;
+
+	Common::OutSaveFile *out = g_system->getSaveFileManager()->openForSaving(kDetectionCacheName, false);
+	if (!out)
+		return;
+
+	out->writeUint32BE(kDetectionCacheTag);
+	out->writeUint16LE(kDetectionCacheVersion);
+	out->writeUint32LE(_entries.size());
+	for (EntryMap::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+		out->writeString(it->_key);
+		out->writeByte(0);
+		out->writeByte(it->_value.isAck ? 1 : 0);
+		out->writeString(it->_value.md5);
+		out->writeByte(0);
+	}
+	out->finalize();
+	delete out;
+	_dirty = false;
+}
+
+static DetectionCache s_detectionCache;
+
+// Cheap structural checks on the menu skin: a bitmap the engine can load.
+static bool isAckSkin(Common::SeekableReadStream &stream) {
+	byte data[SkinHeader::kSize];
+	if (stream.size() < (int32)sizeof(data) || stream.read(data, sizeof(data)) != sizeof(data))
+		return false;
+	SkinHeader header;
+	return header.parse(data, stream.size());
+}
+
+// Looks for an adventure's MASTER.DAT beside the skin and reads the version
+// it was written by. Returns 0 if there is none or it doesn't look like ACK.
+static int16 findAdventure(const FileMap &allFiles, Common::String &adventure) {
+	for (FileMap::const_iterator it = allFiles.begin(); it != allFiles.end(); ++it) {
+		const Common::String &name = it->_key;
+		if (name.size() <= 10 || !name.hasSuffixIgnoreCase("MASTER.DAT"))
+			continue;
+
+		Common::SeekableReadStream *stream = it->_value.createReadStream();
+		if (!stream)
+			continue;
+
+		MasterRec master;
+		bool ok = stream->size() >= (int32)MasterRec::kFileSize && master.load(*stream);
+		delete stream;
+		if (ok && master.ackVersion >= kMinAckVersion && master.ackVersion <= kMaxAckVersion) {
+			adventure = Common::String(name.c_str(), name.size() - 10);
+			return master.ackVersion;
+		}
+	}
+	return 0;
+}
+
+static AckGameDescription s_fallbackDesc;
+static char s_fallbackExtra[32];
+static char s_fallbackMD5[33];
+static ADGameFileDescription s_fallbackFiles[] = {
+	{ "ACKDATA0.DAT", 0, s_fallbackMD5, AD_NO_SIZE },
+	AD_LISTEND
+};
+
+class AckMetaEngineDetection : public AdvancedMetaEngineDetection {
+public:
+	AckMetaEngineDetection() : AdvancedMetaEngineDetection(gameDescriptions, sizeof(AckGameDescription), ackGames, optionsList) {
+	}
+
+	const char *getName() const override {
+		return "ack";
+	}
+
+	const char *getEngineName() const override {
+		return "ACK";
+	}
+
+	const char *getOriginalCopyright() const override {
+		return "Adventure Creation Kit (C) Chris Hopkins";
+	}
+
+	DetectedGames detectGames(const Common::FSList &fslist, uint32 skipADFlags, bool skipIncomplete) override;
+
+	ADDetectedGame fallbackDetect(const FileMap &allFiles, const Common::FSList &fslist, ADDetectedGameExtraInfo **extra) const override;
+};
+
+DetectedGames AckMetaEngineDetection::detectGames(const Common::FSList &fslist, uint32 skipADFlags, bool skipIncomplete) {
+	// Verdicts found during the scan are written back once, at its end.
+	DetectedGames games = AdvancedMetaEngineDetection::detectGames(fslist, skipADFlags, skipIncomplete);
+	s_detectionCache.save();
+	return games;
+}
+
+ADDetectedGame AckMetaEngineDetection::fallbackDetect(const FileMap &allFiles, const Common::FSList &fslist, ADDetectedGameExtraInfo **extra) const {
+	FileMap::const_iterator skin = allFiles.find("ACKDATA0.DAT");
+	if (skin == allFiles.end())
+		return ADDetectedGame();
+
+	Common::SeekableReadStream *stream = skin->_value.createReadStream();
+	if (!stream)
+		return ADDetectedGame();
+
+	// A skin seen before at the same size is not read or hashed again.
+	Common::String key = Common::String::format("%s:%d", skin->_value.getPath().c_str(), (int)stream->size());
+	const DetectionCache::Entry *cached = s_detectionCache.find(key);
+	DetectionCache::Entry entry;
+	if (cached) {
+		entry = *cached;
+	} else {
+		entry.isAck = isAckSkin(*stream);
+		if (entry.isAck) {
+			stream->seek(0);
+			entry.md5 = Common::computeStreamMD5AsString(*stream, kDetectionHashBytes);
+		}
+		s_detectionCache.store(key, entry);
+	}
+	delete stream;
+
+	if (!entry.isAck)
+		return ADDetectedGame();
+
+	Common::String adventure;
+	int16 ackVersion = findAdventure(allFiles, adventure);
+
+	s_fallbackDesc.desc.gameId = "ack";
+	Common::strlcpy(s_fallbackExtra, adventure.c_str(), sizeof(s_fallbackExtra));
+	s_fallbackDesc.desc.extra = s_fallbackExtra;
+	Common::strlcpy(s_fallbackMD5, entry.md5.c_str(), sizeof(s_fallbackMD5));
+	s_fallbackDesc.desc.filesDescriptions = s_fallbackFiles;
+	s_fallbackDesc.desc.language = Common::UNK_LANG;
+	s_fallbackDesc.desc.platform = Common::kPlatformDOS;
+	s_fallbackDesc.desc.flags = ADGF_NO_FLAGS;
+	s_fallbackDesc.desc.guiOptions = GUIO1(GUIO_NOMIDI);
+	s_fallbackDesc.gameType = ackVersion;
+
+	debug(1, "Detected ACK adventure '%s' (%d)", s_fallbackExtra, ackVersion);
+	return ADDetectedGame(&s_fallbackDesc.desc);
+}
+
 } // End of namespace Ack
+
+REGISTER_PLUGIN_STATIC(ACK_DETECTION, PLUGIN_TYPE_ENGINE_DETECTION, Ack::AckMetaEngineDetection);
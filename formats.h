@@ -0,0 +1,86 @@
+/* ScummVM - ACK Engine File Formats
+ *
+ * Decoders for the fixed-layout data files, kept inline so detection,
+ * which is linked into the executable even when the engine is a plugin,
+ * can use them without reaching into the engine.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_FORMATS_H
+#define ACK_FORMATS_H
+
+#include "common/scummsys.h"
+#include "common/endian.h"
+#include "common/stream.h"
+
+namespace Ack {
+
+// Master record for game configuration data.
+struct MasterRec {
+	byte textColors[10];
+	int ackVersion;
+	byte phaseColors[3][5][4];
+
+	// Size of the record in MASTER.DAT, which is little-endian and unpadded.
+	static const uint32 kFileSize = 10 + 2 + 3 * 5 * 4;
+
+	bool load(Common::ReadStream &stream) {
+		stream.read(textColors, sizeof(textColors));
+		ackVersion = stream.readSint16LE();
+		stream.read(phaseColors, sizeof(phaseColors));
+		return !stream.err() && !stream.eos();
+	}
+
+	void save(Common::WriteStream &stream) const {
+		stream.write(textColors, sizeof(textColors));
+		stream.writeSint16LE(ackVersion);
+		stream.write(phaseColors, sizeof(phaseColors));
+	}
+};
+
+// Layout of the menu skin bitmap, ACKDATA0.DAT.
+struct SkinHeader {
+	// Bytes of the fixed BMP header parse() reads.
+	static const uint32 kSize = 54;
+
+	// Largest skin the menu can show.
+	static const int32 kMaxWidth = 320;
+	static const int32 kMaxHeight = 200;
+
+	uint32 dataOffset;
+	int32 width, height;
+	bool topDown;
+	uint32 linePitch;
+
+	// Checks the header at the start of a fileSize-byte file holds an
+	// uncompressed 8 bpp bitmap the menu can show.
+	bool parse(const byte *header, uint32 fileSize) {
+		if (fileSize < kSize || header[0] != 'B' || header[1] != 'M')
+			return false;
+
+		dataOffset = READ_LE_UINT32(header + 10);
+		width = (int32)READ_LE_UINT32(header + 18);
+		height = (int32)READ_LE_UINT32(header + 22);
+		uint16 bpp = READ_LE_UINT16(header + 28);
+		uint32 compression = READ_LE_UINT32(header + 30);
+		uint32 colors = READ_LE_UINT32(header + 46);
+		if (dataOffset == 0)
+			dataOffset = kSize + (colors ? colors : 256) * 4;
+
+		// Rows are stored bottom-up unless the height is negative, and each
+		// row is padded to a multiple of four bytes.
+		topDown = height < 0;
+		if (topDown)
+			height = -height;
+		linePitch = (width + 3) & ~3;
+
+		return bpp == 8 && compression == 0 && width > 0 && width <= kMaxWidth &&
+		       height > 0 && height <= kMaxHeight &&
+		       dataOffset <= fileSize && linePitch * height <= fileSize - dataOffset;
+	}
+};
+
+} // End of namespace Ack
+
+#endif // ACK_FORMATS_H
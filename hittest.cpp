@@ -0,0 +1,77 @@
+/* ScummVM - ACK Engine Hit Testing
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/hittest.h"
+
+namespace Ack {
+
+HitTestGrid::HitTestGrid(int width, int height)
+	: _cols((width + kCellSize - 1) / kCellSize)
+	, _rows((height + kCellSize - 1) / kCellSize) {
+	clear();
+}
+
+void HitTestGrid::clear() {
+	_regions.clear();
+	_cellRegions.clear();
+	_cellStart.resize(_cols * _rows + 1);
+	for (uint i = 0; i < _cellStart.size(); i++)
+		_cellStart[i] = 0;
+}
+
+void HitTestGrid::addRegion(const Common::Rect &r, int id) {
+	assert(id != 0);
+	Region region;
+	region.rect = r;
+	region.rect.clip(Common::Rect(_cols * kCellSize, _rows * kCellSize));
+	region.id = id;
+	if (!region.rect.isEmpty())
+		_regions.push_back(region);
+}
+
+void HitTestGrid::build() {
+	// Count the regions per cell, turn the counts into start offsets, then
+	// fill each cell's slice in the order the regions were added.
+	Common::Array<uint16> count;
+	count.resize(_cols * _rows);
+	for (uint i = 0; i < count.size(); i++)
+		count[i] = 0;
+
+	for (uint i = 0; i < _regions.size(); i++) {
+		const Common::Rect &r = _regions[i].rect;
+		for (int cy = r.top / kCellSize; cy <= (r.bottom - 1) / kCellSize; cy++)
+			for (int cx = r.left / kCellSize; cx <= (r.right - 1) / kCellSize; cx++)
+				count[cy * _cols + cx]++;
+	}
+
+	_cellStart[0] = 0;
+	for (uint i = 0; i < count.size(); i++) {
+		_cellStart[i + 1] = _cellStart[i] + count[i];
+		count[i] = _cellStart[i];
+	}
+
+	_cellRegions.resize(_cellStart[count.size()]);
+	for (uint i = 0; i < _regions.size(); i++) {
+		const Common::Rect &r = _regions[i].rect;
+		for (int cy = r.top / kCellSize; cy <= (r.bottom - 1) / kCellSize; cy++)
+			for (int cx = r.left / kCellSize; cx <= (r.right - 1) / kCellSize; cx++)
+				_cellRegions[count[cy * _cols + cx]++] = i;
+	}
+}
+
+int HitTestGrid::hitTest(int x, int y) const {
+	if (x < 0 || y < 0 || x >= _cols * kCellSize || y >= _rows * kCellSize)
+		return 0;
+
+	int cell = (y / kCellSize) * _cols + x / kCellSize;
+	for (uint i = _cellStart[cell]; i < _cellStart[cell + 1]; i++) {
+		const Region &region = _regions[_cellRegions[i]];
+		if (region.rect.contains(x, y))
+			return region.id;
+	}
+	return 0;
+}
+
+} // End of namespace Ack
@@ -0,0 +1,52 @@
+/* ScummVM - ACK Engine Hit Testing
+ *
+ * Maps screen positions to the id of the region under them through a grid
+ * of coarse cells, so a lookup costs the same however many regions exist.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_HITTEST_H
+#define ACK_HITTEST_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Ack {
+
+class HitTestGrid {
+public:
+	static const int kCellSize = 8;
+
+	HitTestGrid(int width, int height);
+
+	// Drops all regions.
+	void clear();
+
+	// Registers a region; ids must be non-zero. Where regions overlap, the
+	// one added first wins. Call build() once all regions are in.
+	void addRegion(const Common::Rect &r, int id);
+	void build();
+
+	// Returns the id of the region containing (x, y), or 0 if there is none.
+	int hitTest(int x, int y) const;
+
+private:
+	struct Region {
+		Common::Rect rect;
+		int id;
+	};
+
+	int _cols, _rows;
+	Common::Array<Region> _regions;
+
+	// For each cell, the regions overlapping it are
+	// _cellRegions[_cellStart[cell] .. _cellStart[cell + 1]).
+	Common::Array<uint16> _cellStart;
+	Common::Array<uint16> _cellRegions;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_HITTEST_H
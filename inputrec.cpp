@@ -0,0 +1,121 @@
+/* ScummVM - ACK Engine Input Recorder
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/inputrec.h"
+
+#include "common/system.h"
+
+namespace Ack {
+
+static const uint32 kInputRecordTag = MKTAG('A', 'C', 'K', 'R');
+static const uint16 kInputRecordVersion = 2;
+
+// tick, type, mouse x/y, keycode, ascii, key flags, engine key code.
+static const uint32 kInputRecordSize = 4 + 1 + 2 + 2 + 2 + 2 + 1 + 1;
+
+InputRecorder::InputRecorder() : _out(nullptr), _endTick(0), _next(0), _replaying(false), _fastForward(false) {
+}
+
+InputRecorder::~InputRecorder() {
+	stop();
+}
+
+bool InputRecorder::startRecording(const Common::String &fileName) {
+	stop();
+	_out = g_system->getSaveFileManager()->openForSaving(fileName, false);
+	if (!_out) {
+		warning("Could not create input recording %s", fileName.c_str());
+		return false;
+	}
+
+	_out->writeUint32BE(kInputRecordTag);
+	_out->writeUint16LE(kInputRecordVersion);
+	return true;
+}
+
+bool InputRecorder::startReplay(const Common::String &fileName, bool fastForward) {
+	stop();
+	Common::InSaveFile *in = g_system->getSaveFileManager()->openForLoading(fileName);
+	if (!in) {
+		warning("Could not open input recording %s", fileName.c_str());
+		return false;
+	}
+
+	if (in->readUint32BE() != kInputRecordTag || in->readUint16LE() != kInputRecordVersion) {
+		warning("%s is not an input recording", fileName.c_str());
+		delete in;
+		return false;
+	}
+
+	// Pull the whole log in up front so replay never touches the disk.
+	uint32 count = (in->size() - in->pos()) / kInputRecordSize;
+	_records.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		Record &rec = _records[i];
+		rec.tick = in->readUint32LE();
+		rec.event.type = (Common::EventType)in->readByte();
+		rec.event.mouse.x = in->readSint16LE();
+		rec.event.mouse.y = in->readSint16LE();
+		rec.event.kbd.keycode = (Common::KeyCode)in->readUint16LE();
+		rec.event.kbd.ascii = in->readUint16LE();
+		rec.event.kbd.flags = in->readByte();
+		rec.key = (char)in->readByte();
+	}
+	delete in;
+
+	// An event-less record marks the tick the session ended on. Without
+	// one, say from a crash, the replay ends with its last event.
+	_endTick = 0;
+	if (!_records.empty()) {
+		_endTick = _records.back().tick;
+		if (_records.back().event.type == Common::EVENT_INVALID)
+			_records.pop_back();
+	}
+
+	_next = 0;
+	_replaying = true;
+	_fastForward = fastForward;
+	return true;
+}
+
+void InputRecorder::stop() {
+	if (_out) {
+		_out->finalize();
+		delete _out;
+		_out = nullptr;
+	}
+	_records.clear();
+	_next = 0;
+	_replaying = false;
+}
+
+void InputRecorder::endRecording(uint32 tick) {
+	if (_out)
+		record(tick, Common::Event(), 0);
+	stop();
+}
+
+void InputRecorder::record(uint32 tick, const Common::Event &event, char key) {
+	_out->writeUint32LE(tick);
+	_out->writeByte(event.type);
+	_out->writeSint16LE(event.mouse.x);
+	_out->writeSint16LE(event.mouse.y);
+	_out->writeUint16LE(event.kbd.keycode);
+	_out->writeUint16LE(event.kbd.ascii);
+	_out->writeByte(event.kbd.flags);
+	_out->writeByte((byte)key);
+}
+
+bool InputRecorder::replay(uint32 tick, Common::Event &event, char &key) {
+	if (_next >= _records.size() || _records[_next].tick > tick)
+		return false;
+
+	event = _records[_next].event;
+	key = _records[_next].key;
+	_next++;
+	return true;
+}
+
+} // End of namespace Ack
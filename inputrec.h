@@ -0,0 +1,67 @@
+/* ScummVM - ACK Engine Input Recorder
+ *
+ * Records the input events the engine handles to a compact binary file and
+ * feeds them back later. Events are stamped with the engine tick on which
+ * they were handled, so a replay reproduces a session exactly whether it
+ * runs at the recorded pace or as fast as possible.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_INPUTREC_H
+#define ACK_INPUTREC_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/events.h"
+#include "common/savefile.h"
+#include "common/str.h"
+
+namespace Ack {
+
+class InputRecorder {
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool startRecording(const Common::String &fileName);
+	bool startReplay(const Common::String &fileName, bool fastForward);
+	void stop();
+
+	// Stamps the tick the recorded session ended on, then stops.
+	void endRecording(uint32 tick);
+
+	bool isRecording() const { return _out != nullptr; }
+	bool isReplaying() const { return _replaying; }
+	bool isFastForward() const { return _replaying && _fastForward; }
+
+	// Whether every event has been replayed and the session's end tick,
+	// until which the frames those events caused were drawn, is reached.
+	bool isReplayFinished(uint32 tick) const {
+		return _replaying && _next >= _records.size() && tick >= _endTick;
+	}
+
+	// Logs an event handled on the given tick, with the engine's key code.
+	void record(uint32 tick, const Common::Event &event, char key);
+
+	// Returns the next recorded event due on or before the given tick.
+	bool replay(uint32 tick, Common::Event &event, char &key);
+
+private:
+	struct Record {
+		uint32 tick;
+		Common::Event event;
+		char key;
+	};
+
+	Common::OutSaveFile *_out;
+	Common::Array<Record> _records;
+	uint32 _endTick;
+	uint _next;
+	bool _replaying;
+	bool _fastForward;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_INPUTREC_H
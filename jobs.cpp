@@ -0,0 +1,87 @@
+/* ScummVM - ACK Engine Decode Jobs
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/jobs.h"
+#include "engines/ack/cache.h"
+
+#include "common/system.h"
+
+namespace Ack {
+
+JobQueue::~JobQueue() {
+	cancelAll();
+}
+
+void JobQueue::schedule(DecodeJob *job, bool urgent) {
+	if (urgent)
+		_jobs.insert_at(0, job);
+	else
+		_jobs.push_back(job);
+}
+
+bool JobQueue::isPending(const Common::String &name) const {
+	for (uint i = 0; i < _jobs.size(); i++) {
+		if (_jobs[i]->getName() == name)
+			return true;
+	}
+	return false;
+}
+
+void JobQueue::finish(const Common::String &name) {
+	for (uint i = 0; i < _jobs.size(); i++) {
+		if (_jobs[i]->getName() != name)
+			continue;
+		DecodeJob *job = _jobs.remove_at(i);
+		while (!job->step())
+			;
+		delete job;
+		return;
+	}
+}
+
+void JobQueue::run(uint32 deadline) {
+	// Signed difference, so the comparison survives the clock wrapping.
+	while (!_jobs.empty() && (int32)(deadline - g_system->getMillis()) > 0) {
+		if (_jobs[0]->step())
+			delete _jobs.remove_at(0);
+	}
+}
+
+void JobQueue::cancelAll() {
+	for (uint i = 0; i < _jobs.size(); i++)
+		delete _jobs[i];
+	_jobs.clear();
+}
+
+TileSetJob::TileSetJob(const Common::String &name, Common::SeekableReadStream *stream, ResourceCache *cache,
+                       ResourceHandle<IconSetResource> *result)
+	: DecodeJob(name), _stream(stream), _cache(cache), _result(result), _next(1) {
+	_res = new IconSetResource();
+	memset(_res->tiles, 0, sizeof(_res->tiles));
+}
+
+TileSetJob::~TileSetJob() {
+	delete _stream;
+	delete _res;
+}
+
+bool TileSetJob::step() {
+	Grap256Unit rec;
+	for (int i = 0; i < kTilesPerStep && _next <= kIconSetSize; i++, _next++) {
+		if (_stream->read(&rec, sizeof(Grap256Unit)) != sizeof(Grap256Unit)) {
+			_next = kIconSetSize + 1;
+			break;
+		}
+		_res->tiles[_next].decode(rec);
+	}
+	if (_next <= kIconSetSize)
+		return false;
+
+	*_result = _cache->put(getName(), _res);
+	_res = nullptr;
+	return true;
+}
+
+} // End of namespace Ack
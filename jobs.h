@@ -0,0 +1,85 @@
+/* ScummVM - ACK Engine Decode Jobs
+ *
+ * Tile and region decoding split into small resumable jobs. Engines get no
+ * threads from the backend, so the queue is worked cooperatively in the
+ * slack of each main loop tick; anything needed at once is finished on
+ * demand instead.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_JOBS_H
+#define ACK_JOBS_H
+
+#include "common/array.h"
+#include "common/stream.h"
+#include "common/str.h"
+
+namespace Ack {
+
+class ResourceCache;
+struct IconSetResource;
+template<class T> class ResourceHandle;
+
+class DecodeJob {
+public:
+	explicit DecodeJob(const Common::String &name) : _name(name) {}
+	virtual ~DecodeJob() {}
+
+	// Does one short slice of the work; returns true once it is all done.
+	virtual bool step() = 0;
+
+	const Common::String &getName() const { return _name; }
+
+private:
+	Common::String _name;
+};
+
+class JobQueue {
+public:
+	~JobQueue();
+
+	// Takes ownership of job. Urgent jobs, such as the region about to be
+	// entered, run ahead of prefetches.
+	void schedule(DecodeJob *job, bool urgent = false);
+
+	bool isPending(const Common::String &name) const;
+	bool isIdle() const { return _jobs.empty(); }
+
+	// Runs the named job to completion now, if it is queued.
+	void finish(const Common::String &name);
+
+	// Steps queued jobs until the clock reaches deadline, in milliseconds.
+	void run(uint32 deadline);
+
+	void cancelAll();
+
+private:
+	Common::Array<DecodeJob *> _jobs;
+};
+
+// Decodes a tile file a few records per step into an icon set, filed in the
+// resource cache under the job's name when complete. The set is handed to
+// result, which keeps it resident until its owner lets go.
+class TileSetJob : public DecodeJob {
+public:
+	// Takes ownership of stream; result must outlive the job.
+	TileSetJob(const Common::String &name, Common::SeekableReadStream *stream, ResourceCache *cache,
+	           ResourceHandle<IconSetResource> *result);
+	~TileSetJob() override;
+
+	bool step() override;
+
+private:
+	static const int kTilesPerStep = 8;
+
+	Common::SeekableReadStream *_stream;
+	ResourceCache *_cache;
+	ResourceHandle<IconSetResource> *_result;
+	IconSetResource *_res;
+	int _next;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_JOBS_H
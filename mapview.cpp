@@ -0,0 +1,215 @@
+/* ScummVM - ACK Engine Map View
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/mapview.h"
+#include "engines/ack/blit.h"
+
+#include "common/util.h"
+
+namespace Ack {
+
+MapView::MapView(int cols, int rows)
+	: _cols(cols), _rows(rows), _originX(0), _originY(0), _tiles(nullptr),
+	  _terrain(nullptr), _objects(nullptr), _mapWidth(0), _mapHeight(0),
+	  _layerPitch(cols * kTileSize), _layerValid(false), _allDirty(true), _shiftX(0), _shiftY(0) {
+	_layer.resize(_layerPitch * rows * kTileSize);
+	_dirty.resize(cols * rows);
+	_dirtyScratch.resize(cols * rows);
+}
+
+void MapView::setMap(const byte *terrain, const byte *objects, int width, int height) {
+	_terrain = terrain;
+	_objects = objects;
+	_mapWidth = width;
+	_mapHeight = height;
+	_originX = _originY = 0;
+	invalidate();
+}
+
+void MapView::setTiles(const TileStore *tiles) {
+	_tiles = tiles;
+	invalidate();
+}
+
+void MapView::invalidate() {
+	_layerValid = false;
+	markAllDirty();
+}
+
+void MapView::markAllDirty() {
+	_allDirty = true;
+	_shiftX = _shiftY = 0;
+}
+
+bool MapView::toView(int mapX, int mapY, int &col, int &row) const {
+	col = mapX - _originX;
+	row = mapY - _originY;
+	return col >= 0 && col < _cols && row >= 0 && row < _rows;
+}
+
+void MapView::objectChanged(int mapX, int mapY) {
+	int col, row;
+	if (toView(mapX, mapY, col, row))
+		_dirty[row * _cols + col] = true;
+}
+
+void MapView::terrainChanged(int mapX, int mapY) {
+	int col, row;
+	if (!toView(mapX, mapY, col, row))
+		return;
+	if (_layerValid)
+		composeCell(col, row);
+	_dirty[row * _cols + col] = true;
+}
+
+void MapView::composeCell(int col, int row) {
+	byte *dst = &_layer[row * kTileSize * _layerPitch + col * kTileSize];
+	int mapX = _originX + col, mapY = _originY + row;
+	byte slot = 0;
+	if (mapX >= 0 && mapX < _mapWidth && mapY >= 0 && mapY < _mapHeight)
+		slot = _terrain[mapY * _mapWidth + mapX];
+
+	if (_tiles->contains(slot)) {
+		blitFixed<kTileSize, kTileSize, kBlitOpaque, 0, kTileSize>(dst, _layerPitch, &(*_tiles)[slot].pixels[0][0], 0);
+	} else {
+		for (int y = 0; y < kTileSize; y++)
+			memset(dst + y * _layerPitch, 0, kTileSize);
+	}
+}
+
+void MapView::composeColumns(int first, int count) {
+	for (int row = 0; row < _rows; row++) {
+		for (int col = first; col < first + count; col++)
+			composeCell(col, row);
+	}
+}
+
+void MapView::composeRows(int first, int count) {
+	for (int row = first; row < first + count; row++) {
+		for (int col = 0; col < _cols; col++)
+			composeCell(col, row);
+	}
+}
+
+void MapView::shiftViewport(byte *buf, int pitch, int dx, int dy) const {
+	// Moves the viewport's pixels so that cell (col + dx, row + dy) lands on
+	// (col, row); the cells left behind keep stale pixels.
+	int width = getWidth(), height = getHeight();
+	int shiftX = dx * kTileSize, shiftY = dy * kTileSize;
+	if (shiftY > 0) {
+		for (int y = 0; y < height - shiftY; y++)
+			memmove(buf + y * pitch, buf + (y + shiftY) * pitch, width);
+	} else if (shiftY < 0) {
+		for (int y = height - 1; y >= -shiftY; y--)
+			memmove(buf + y * pitch, buf + (y + shiftY) * pitch, width);
+	}
+	if (shiftX) {
+		int keep = width - ABS(shiftX);
+		for (int y = 0; y < height; y++) {
+			byte *line = buf + y * pitch;
+			if (shiftX > 0)
+				memmove(line, line + shiftX, keep);
+			else
+				memmove(line - shiftX, line, keep);
+		}
+	}
+}
+
+void MapView::shiftDirty(int dx, int dy) {
+	// Cells carry their dirty flag along; those scrolled into view are new.
+	for (int row = 0; row < _rows; row++) {
+		for (int col = 0; col < _cols; col++) {
+			int srcCol = col + dx, srcRow = row + dy;
+			bool inside = srcCol >= 0 && srcCol < _cols && srcRow >= 0 && srcRow < _rows;
+			_dirtyScratch[row * _cols + col] = !inside || _dirty[srcRow * _cols + srcCol];
+		}
+	}
+	_dirty.swap(_dirtyScratch);
+}
+
+void MapView::scrollTo(int originX, int originY) {
+	int dx = originX - _originX, dy = originY - _originY;
+	if (!dx && !dy)
+		return;
+
+	_originX = originX;
+	_originY = originY;
+
+	// A jump past a whole viewport leaves nothing worth keeping.
+	if (!_layerValid || ABS(dx) >= _cols || ABS(dy) >= _rows) {
+		_layerValid = false;
+		markAllDirty();
+		return;
+	}
+
+	// What was drawn follows the layer at the next draw(), so only the
+	// exposed edge is redrawn there.
+	if (!_allDirty) {
+		_shiftX += dx;
+		_shiftY += dy;
+		if (ABS(_shiftX) >= _cols || ABS(_shiftY) >= _rows)
+			markAllDirty();
+		else
+			shiftDirty(dx, dy);
+	}
+
+	// Shift what stays visible, then compose the cells scrolled into view.
+	shiftViewport(&_layer[0], _layerPitch, dx, dy);
+	if (dy > 0)
+		composeRows(_rows - dy, dy);
+	else if (dy < 0)
+		composeRows(0, -dy);
+	if (dx > 0)
+		composeColumns(_cols - dx, dx);
+	else if (dx < 0)
+		composeColumns(0, -dx);
+}
+
+Common::Rect MapView::draw(byte *dst, int pitch) {
+	if (!_terrain || !_tiles)
+		return Common::Rect();
+
+	if (!_layerValid) {
+		composeRows(0, _rows);
+		_layerValid = true;
+		markAllDirty();
+	}
+
+	Common::Rect changed;
+	if (_shiftX || _shiftY) {
+		shiftViewport(dst, pitch, _shiftX, _shiftY);
+		changed = Common::Rect(getWidth(), getHeight());
+		_shiftX = _shiftY = 0;
+	}
+	for (int row = 0; row < _rows; row++) {
+		for (int col = 0; col < _cols; col++) {
+			bool &dirty = _dirty[row * _cols + col];
+			if (!_allDirty && !dirty)
+				continue;
+			dirty = false;
+
+			const byte *src = &_layer[row * kTileSize * _layerPitch + col * kTileSize];
+			byte *out = dst + row * kTileSize * pitch + col * kTileSize;
+			blitFixed<kTileSize, kTileSize, kBlitOpaque>(out, pitch, src, _layerPitch);
+
+			int mapX = _originX + col, mapY = _originY + row;
+			if (_objects && mapX >= 0 && mapX < _mapWidth && mapY >= 0 && mapY < _mapHeight) {
+				byte slot = _objects[mapY * _mapWidth + mapX];
+				if (_tiles->contains(slot))
+					blitTileKeyed(out, pitch, (*_tiles)[slot], kTransparentColor);
+			}
+
+			Common::Rect cell(col * kTileSize, row * kTileSize, (col + 1) * kTileSize, (row + 1) * kTileSize);
+			if (changed.isEmpty())
+				changed = cell;
+			else
+				changed.extend(cell);
+		}
+	}
+	_allDirty = false;
+	return changed;
+}
+
+} // End of namespace Ack
@@ -0,0 +1,85 @@
+/* ScummVM - ACK Engine Map View
+ *
+ * Renders the play screen's tile map. Terrain is composed once into an
+ * offscreen layer; objects and creatures are overlaid on top of it, so a
+ * move only redraws the cells it touched, and a scroll shifts the layer
+ * and draws just the exposed edge.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_MAPVIEW_H
+#define ACK_MAPVIEW_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/rect.h"
+
+#include "engines/ack/tiles.h"
+
+namespace Ack {
+
+class MapView {
+public:
+	// A viewport of cols x rows cells.
+	MapView(int cols, int rows);
+
+	// Borrows a map of width x height cells, row-major, each holding the
+	// graphic slot of its terrain and of the object on it, 0 for none.
+	// The arrays must outlive the view or the next setMap() call.
+	void setMap(const byte *terrain, const byte *objects, int width, int height);
+	void setTiles(const TileStore *tiles);
+	bool hasMap() const { return _terrain != nullptr; }
+
+	int getWidth() const { return _cols * kTileSize; }
+	int getHeight() const { return _rows * kTileSize; }
+
+	// Report edits to the borrowed map. Object changes cost one cell
+	// redraw; terrain changes also recompose that cell of the layer.
+	void objectChanged(int mapX, int mapY);
+	void terrainChanged(int mapX, int mapY);
+
+	// Drops the cached layer, as after a change of tiles.
+	void invalidate();
+
+	// Moves the top-left map cell shown.
+	void scrollTo(int originX, int originY);
+
+	// Brings a viewport drawn at dst up to date and returns the area that
+	// changed, relative to dst. dst must still hold what the last call drew
+	// there, since a scroll moves it in place; invalidate() after anything
+	// else has drawn over it.
+	Common::Rect draw(byte *dst, int pitch);
+
+private:
+	bool toView(int mapX, int mapY, int &col, int &row) const;
+	void composeCell(int col, int row);
+	void composeColumns(int first, int count);
+	void composeRows(int first, int count);
+	void shiftViewport(byte *buf, int pitch, int dx, int dy) const;
+	void shiftDirty(int dx, int dy);
+	void markAllDirty();
+
+	int _cols, _rows;
+	int _originX, _originY;
+	const TileStore *_tiles;
+	const byte *_terrain;
+	const byte *_objects;
+	int _mapWidth, _mapHeight;
+
+	// Terrain of the viewport, one tile per cell.
+	Common::Array<byte> _layer;
+	int _layerPitch;
+	bool _layerValid;
+
+	// Viewport cells that differ from what was last drawn.
+	Common::Array<bool> _dirty, _dirtyScratch;
+	bool _allDirty;
+
+	// Scroll, in cells, that what was last drawn still has to follow.
+	int _shiftX, _shiftY;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_MAPVIEW_H
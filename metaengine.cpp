@@ -7,6 +7,7 @@
 
 #include "engines/ack/ack.h"
 #include "engines/ack/detection.h"
+#include "engines/ack/saveindex.h"
 
 #include "engines/advancedDetector.h"
 #include "common/system.h"
@@ -41,22 +42,18 @@ public:
 	SaveStateList listSaves(const char *target) const override {
 		Common::SaveFileManager *saveFileMan = g_system->getSaveFileManager();
 		Common::StringArray filenames;
-		Common::String saveDesc;
 		Common::String pattern = Common::String::format("%s.??", target);
 		filenames = saveFileMan->listSavefiles(pattern);
 
+		// Answer from the index; only scan the saves themselves when it is
+		// missing or no longer lists the slots that exist.
+		SaveIndex index(target);
+		index.refresh(filenames);
+
 		SaveStateList saveList;
-		for (Common::StringArray::const_iterator file = filenames.begin(); file != filenames.end(); ++file) {
-			int slotNum = atoi(file->c_str() + file->size() - 2);
-			if (slotNum >= 0 && slotNum <= 99) {
-				Common::InSaveFile *in = saveFileMan->openForLoading(*file);
-				if (in) {
-					saveDesc = in->readString();
-					saveList.push_back(SaveStateDescriptor(slotNum, saveDesc));
-					delete in;
-				}
-			}
-		}
+		const Common::Array<SaveIndexEntry> &entries = index.getEntries();
+		for (uint i = 0; i < entries.size(); i++)
+			saveList.push_back(SaveStateDescriptor(entries[i].slot, entries[i].description));
 
 		Common::sort(saveList.begin(), saveList.end(), SaveStateDescriptorSlotComparator());
 		return saveList;
@@ -69,6 +66,12 @@ public:
 	void removeSaveState(const char *target, int slot) const override {
 		Common::String filename = Common::String::format("%s.%02d", target, slot);
 		g_system->getSaveFileManager()->removeSavefile(filename);
+
+		SaveIndex index(target);
+		if (index.load()) {
+			index.remove(slot);
+			index.save();
+		}
 	}
 
 	SaveStateDescriptor querySaveMetaInfos(const char *target, int slot) const override {
@@ -86,5 +89,6 @@ public:
 		int hour = in->readSint16LE();
 		int minutes = in->readSint16LE();
 		desc.setSaveTime(hour, minutes);
+		desc.setPlayTime(in->readUint32LE());
 		if (in->readByte() == 1) {
 			int thumbWidth = in->readUint16LE();
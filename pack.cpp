@@ -0,0 +1,318 @@
+/* ScummVM - ACK Engine Data Packs
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/pack.h"
+
+#include "common/file.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Ack {
+
+static const uint32 kPackTag = MKTAG('A', 'C', 'K', 'P');
+static const uint16 kPackVersion = 1;
+static const uint32 kPackAlignment = 16;
+
+enum {
+	kPackStored = 0,
+	kPackLZ = 1
+};
+
+// Decodes one LZ4-format block. Returns false unless it produces exactly
+// dstSize bytes without reading or writing out of bounds.
+static bool lzDecompress(const byte *src, uint32 srcSize, byte *dst, uint32 dstSize) {
+	const byte *ip = src, *iend = src + srcSize;
+	byte *op = dst, *oend = dst + dstSize;
+
+	while (ip < iend) {
+		byte token = *ip++;
+
+		uint32 literals = token >> 4;
+		if (literals == 15) {
+			byte b;
+			do {
+				if (ip >= iend)
+					return false;
+				b = *ip++;
+				literals += b;
+			} while (b == 255);
+		}
+		if (literals > (uint32)(iend - ip) || literals > (uint32)(oend - op))
+			return false;
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		// The last sequence carries literals only.
+		if (ip >= iend)
+			break;
+
+		if (iend - ip < 2)
+			return false;
+		uint32 offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (uint32)(op - dst))
+			return false;
+
+		uint32 length = token & 15;
+		if (length == 15) {
+			byte b;
+			do {
+				if (ip >= iend)
+					return false;
+				b = *ip++;
+				length += b;
+			} while (b == 255);
+		}
+		length += 4;
+		if (length > (uint32)(oend - op))
+			return false;
+
+		// Matches may overlap their own output, so copy bytewise.
+		const byte *match = op - offset;
+		for (uint32 i = 0; i < length; i++)
+			*op++ = *match++;
+	}
+
+	return op == oend;
+}
+
+static void lzWriteLength(Common::Array<byte> &out, uint32 length) {
+	while (length >= 255) {
+		out.push_back(255);
+		length -= 255;
+	}
+	out.push_back(length);
+}
+
+static void lzWriteSequence(Common::Array<byte> &out, const byte *literals, uint32 literalCount,
+                            uint32 offset, uint32 matchLength) {
+	uint32 match = matchLength ? matchLength - 4 : 0;
+	out.push_back((MIN<uint32>(literalCount, 15) << 4) | MIN<uint32>(match, 15));
+	if (literalCount >= 15)
+		lzWriteLength(out, literalCount - 15);
+	for (uint32 i = 0; i < literalCount; i++)
+		out.push_back(literals[i]);
+
+	if (matchLength) {
+		out.push_back(offset & 0xFF);
+		out.push_back(offset >> 8);
+		if (match >= 15)
+			lzWriteLength(out, match - 15);
+	}
+}
+
+// Greedy single-pass LZ4-format encoder with a small hash table, tuned for
+// being simple rather than for ratio: pack building is an offline step.
+static void lzCompress(const byte *src, uint32 size, Common::Array<byte> &out) {
+	const int kHashBits = 12;
+	int32 table[1 << kHashBits];
+	for (int i = 0; i < (1 << kHashBits); i++)
+		table[i] = -1;
+
+	uint32 anchor = 0, i = 0;
+	while (i + 4 <= size) {
+		uint32 seq = READ_LE_UINT32(src + i);
+		uint32 hash = (seq * 2654435761U) >> (32 - kHashBits);
+		int32 candidate = table[hash];
+		table[hash] = i;
+
+		if (candidate < 0 || i - candidate > 65535 || READ_LE_UINT32(src + candidate) != seq) {
+			i++;
+			continue;
+		}
+
+		uint32 length = 4;
+		while (i + length < size && src[candidate + length] == src[i + length])
+			length++;
+
+		lzWriteSequence(out, src + anchor, i - anchor, i - candidate, length);
+		i += length;
+		anchor = i;
+	}
+
+	lzWriteSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+PackArchive::PackArchive(Common::SeekableReadStream *stream) : _stream(stream) {
+}
+
+PackArchive::~PackArchive() {
+	delete _stream;
+}
+
+PackArchive *PackArchive::open(const Common::String &fileName) {
+	// Packs built by writePack() land in the save directory; installed ones
+	// sit next to the game data.
+	Common::SeekableReadStream *stream = nullptr;
+	Common::File *file = new Common::File();
+	if (file->open(fileName))
+		stream = file;
+	else
+		delete file;
+	if (!stream)
+		stream = g_system->getSaveFileManager()->openForLoading(fileName);
+	if (!stream)
+		return nullptr;
+
+	PackArchive *pack = new PackArchive(stream);
+	if (!pack->readIndex()) {
+		warning("%s is not a valid data pack", fileName.c_str());
+		delete pack;
+		return nullptr;
+	}
+	return pack;
+}
+
+bool PackArchive::readIndex() {
+	if (_stream->readUint32BE() != kPackTag || _stream->readUint16LE() != kPackVersion)
+		return false;
+
+	uint16 count = _stream->readUint16LE();
+	uint32 fileSize = _stream->size();
+	for (uint16 i = 0; i < count; i++) {
+		Entry entry;
+		byte nameLength = _stream->readByte();
+		char name[256];
+		_stream->read(name, nameLength);
+		name[nameLength] = 0;
+		entry.name = name;
+		entry.offset = _stream->readUint32LE();
+		entry.packedSize = _stream->readUint32LE();
+		entry.size = _stream->readUint32LE();
+		entry.method = _stream->readByte();
+
+		if (_stream->err() || _stream->eos() || entry.offset > fileSize ||
+		    entry.packedSize > fileSize - entry.offset || entry.method > kPackLZ)
+			return false;
+		_entries[entry.name] = entry;
+	}
+	return true;
+}
+
+bool PackArchive::hasFile(const Common::Path &path) const {
+	return _entries.contains(path.toString());
+}
+
+int PackArchive::listMembers(Common::ArchiveMemberList &list) const {
+	for (EntryMap::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+		list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(it->_value.name, this)));
+	return _entries.size();
+}
+
+const Common::ArchiveMemberPtr PackArchive::getMember(const Common::Path &path) const {
+	if (!hasFile(path))
+		return Common::ArchiveMemberPtr();
+	return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path.toString(), this));
+}
+
+Common::SeekableReadStream *PackArchive::createReadStreamForMember(const Common::Path &path) const {
+	EntryMap::const_iterator it = _entries.find(path.toString());
+	if (it == _entries.end())
+		return nullptr;
+
+	// Members are small; handing out an in-memory copy keeps every stream
+	// independent of the shared pack file position.
+	const Entry &entry = it->_value;
+	byte *data = (byte *)malloc(MAX<uint32>(entry.size, 1));
+	if (!data)
+		return nullptr;
+
+	bool ok;
+	_stream->seek(entry.offset);
+	if (entry.method == kPackStored) {
+		ok = entry.packedSize == entry.size && _stream->read(data, entry.size) == entry.size;
+	} else {
+		byte *packed = (byte *)malloc(MAX<uint32>(entry.packedSize, 1));
+		ok = packed && _stream->read(packed, entry.packedSize) == entry.packedSize &&
+		     lzDecompress(packed, entry.packedSize, data, entry.size);
+		free(packed);
+	}
+
+	if (!ok) {
+		warning("Corrupt data pack member %s", entry.name.c_str());
+		free(data);
+		return nullptr;
+	}
+	return new Common::MemoryReadStream(data, entry.size, DisposeAfterUse::YES);
+}
+
+bool writePack(const Common::String &packName, const Common::String &dir,
+               const Common::StringArray &files, bool compress) {
+	struct Packed {
+		Common::String name;
+		Common::Array<byte> data;
+		uint32 size;
+		byte method;
+	};
+	Common::Array<Packed> entries;
+
+	for (uint i = 0; i < files.size(); i++) {
+		Common::File in;
+		if (!in.open(dir + files[i]))
+			continue;
+
+		Common::Array<byte> raw;
+		raw.resize(in.size());
+		if (raw.size() && in.read(&raw[0], raw.size()) != raw.size())
+			continue;
+
+		Packed entry;
+		entry.name = files[i];
+		entry.size = raw.size();
+		entry.method = kPackStored;
+		if (compress && raw.size())
+			lzCompress(&raw[0], raw.size(), entry.data);
+		if (entry.data.size() && entry.data.size() < raw.size())
+			entry.method = kPackLZ;
+		else
+			entry.data = raw;
+		entries.push_back(entry);
+	}
+
+	Common::OutSaveFile *out = g_system->getSaveFileManager()->openForSaving(packName, false);
+	if (!out)
+		return false;
+
+	// Lay the entries out after the index, each on an aligned offset.
+	uint32 offset = 4 + 2 + 2;
+	for (uint i = 0; i < entries.size(); i++)
+		offset += 1 + entries[i].name.size() + 4 + 4 + 4 + 1;
+
+	out->writeUint32BE(kPackTag);
+	out->writeUint16LE(kPackVersion);
+	out->writeUint16LE(entries.size());
+	Common::Array<uint32> offsets;
+	for (uint i = 0; i < entries.size(); i++) {
+		offset = (offset + kPackAlignment - 1) & ~(kPackAlignment - 1);
+		offsets.push_back(offset);
+
+		out->writeByte(entries[i].name.size());
+		out->writeString(entries[i].name);
+		out->writeUint32LE(offset);
+		out->writeUint32LE(entries[i].data.size());
+		out->writeUint32LE(entries[i].size);
+		out->writeByte(entries[i].method);
+		offset += entries[i].data.size();
+	}
+
+	uint32 pos = out->pos();
+	for (uint i = 0; i < entries.size(); i++) {
+		for (; pos < offsets[i]; pos++)
+			out->writeByte(0);
+		if (entries[i].data.size())
+			out->write(&entries[i].data[0], entries[i].data.size());
+		pos += entries[i].data.size();
+	}
+
+	out->finalize();
+	bool ok = !out->err();
+	delete out;
+	return ok;
+}
+
+} // End of namespace Ack
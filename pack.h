@@ -0,0 +1,59 @@
+/* ScummVM - ACK Engine Data Packs
+ *
+ * A pack bundles an adventure's loose data files into one file: an indexed
+ * header followed by 16-byte-aligned entries, each stored as is or
+ * LZ4-style block compressed. Opening one file instead of many is what
+ * matters on slow or network-mounted storage.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_PACK_H
+#define ACK_PACK_H
+
+#include "common/archive.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str-array.h"
+#include "common/stream.h"
+
+namespace Ack {
+
+class PackArchive : public Common::Archive {
+public:
+	~PackArchive() override;
+
+	// Opens a pack, or returns nullptr if the file is missing or malformed.
+	static PackArchive *open(const Common::String &fileName);
+
+	bool hasFile(const Common::Path &path) const override;
+	int listMembers(Common::ArchiveMemberList &list) const override;
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override;
+	Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override;
+
+private:
+	struct Entry {
+		Common::String name;
+		uint32 offset;
+		uint32 packedSize;
+		uint32 size;
+		byte method;
+	};
+
+	typedef Common::HashMap<Common::String, Entry, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> EntryMap;
+
+	explicit PackArchive(Common::SeekableReadStream *stream);
+	bool readIndex();
+
+	Common::SeekableReadStream *_stream;
+	EntryMap _entries;
+};
+
+// Packs the given files, found under dir, into the save file packName.
+// Entries are compressed wherever that makes them smaller.
+bool writePack(const Common::String &packName, const Common::String &dir,
+               const Common::StringArray &files, bool compress);
+
+} // End of namespace Ack
+
+#endif // ACK_PACK_H
@@ -0,0 +1,77 @@
+/* ScummVM - ACK Engine Profiler
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/profiler.h"
+
+namespace Ack {
+
+static const char *const kTimerNames[kTimerCount] = {
+	"redisplay",
+	"loadIcons",
+	"menuSkinBmp",
+	"loadBmpPalette",
+	"updateScreen"
+};
+
+static const char *const kCounterNames[kCounterCount] = {
+	"presents",
+	"bytes read",
+	"file opens",
+	"resource allocs"
+};
+
+Profiler::Profiler() : _overlay(false) {
+	reset();
+}
+
+void Profiler::reset() {
+	memset(_timers, 0, sizeof(_timers));
+	memset(_counters, 0, sizeof(_counters));
+	memset(_frame, 0, sizeof(_frame));
+	_frames = 0;
+}
+
+void Profiler::addTime(ProfileTimer timer, uint32 millis) {
+	TimerStats &stats = _timers[timer];
+	stats.calls++;
+	stats.totalMillis += millis;
+	stats.maxMillis = MAX(stats.maxMillis, millis);
+}
+
+void Profiler::endFrame() {
+	for (int i = 0; i < kCounterCount; i++) {
+		CounterStats &stats = _counters[i];
+		stats.lastFrame = _frame[i];
+		stats.maxFrame = MAX(stats.maxFrame, _frame[i]);
+		stats.total += _frame[i];
+		_frame[i] = 0;
+	}
+	_frames++;
+}
+
+Common::String Profiler::getReport() const {
+	Common::String report = Common::String::format("%u frames\n", _frames);
+	for (int i = 0; i < kTimerCount; i++) {
+		const TimerStats &stats = _timers[i];
+		report += Common::String::format("%-16s %6u calls %8u ms total %6u ms max\n",
+		                                 kTimerNames[i], stats.calls, stats.totalMillis, stats.maxMillis);
+	}
+	for (int i = 0; i < kCounterCount; i++) {
+		const CounterStats &stats = _counters[i];
+		report += Common::String::format("%-16s %8u total %6u last frame %6u max/frame\n",
+		                                 kCounterNames[i], stats.total, stats.lastFrame, stats.maxFrame);
+	}
+	return report;
+}
+
+Common::String Profiler::getOverlayText() const {
+	return Common::String::format("P%u R%u O%u F%u",
+	                              _counters[kCounterPresents].lastFrame,
+	                              _counters[kCounterBytesRead].lastFrame,
+	                              _counters[kCounterFileOpens].lastFrame,
+	                              _frames);
+}
+
+} // End of namespace Ack
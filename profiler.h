@@ -0,0 +1,99 @@
+/* ScummVM - ACK Engine Profiler
+ *
+ * Lightweight timing and I/O accounting for the engine's hot paths. Scoped
+ * timers accumulate milliseconds per operation, and counters are kept per
+ * frame so that spikes as well as totals can be reported.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_PROFILER_H
+#define ACK_PROFILER_H
+
+#include "common/scummsys.h"
+#include "common/str.h"
+#include "common/system.h"
+
+namespace Ack {
+
+enum ProfileTimer {
+	kTimerRedisplay,
+	kTimerLoadIcons,
+	kTimerMenuSkin,
+	kTimerLoadPalette,
+	kTimerUpdateScreen,
+	kTimerCount
+};
+
+enum ProfileCounter {
+	kCounterPresents,
+	kCounterBytesRead,
+	kCounterFileOpens,
+	// Resources, buffers and files the engine creates. Growth of Common
+	// containers and strings is not seen, so this is no heap allocation count.
+	kCounterResourceAllocs,
+	kCounterCount
+};
+
+class Profiler {
+public:
+	Profiler();
+
+	void reset();
+
+	void addTime(ProfileTimer timer, uint32 millis);
+	void count(ProfileCounter counter, uint32 amount = 1) { _frame[counter] += amount; }
+
+	// Everything counted since the last reset, the open frame included.
+	uint32 getTotal(ProfileCounter counter) const { return _counters[counter].total + _frame[counter]; }
+
+	// Closes the current frame's counters.
+	void endFrame();
+
+	// Multi-line report of everything recorded since the last reset.
+	Common::String getReport() const;
+
+	// One-line summary of the last frame, for the on-screen overlay.
+	Common::String getOverlayText() const;
+
+	bool isOverlayEnabled() const { return _overlay; }
+	void setOverlayEnabled(bool enabled) { _overlay = enabled; }
+
+private:
+	struct TimerStats {
+		uint32 calls;
+		uint32 totalMillis;
+		uint32 maxMillis;
+	};
+
+	struct CounterStats {
+		uint32 lastFrame;
+		uint32 maxFrame;
+		uint32 total;
+	};
+
+	TimerStats _timers[kTimerCount];
+	CounterStats _counters[kCounterCount];
+	uint32 _frame[kCounterCount];
+	uint32 _frames;
+	bool _overlay;
+};
+
+// Charges the time until the end of the enclosing scope to a timer.
+class ProfileScope {
+public:
+	ProfileScope(Profiler *profiler, ProfileTimer timer)
+		: _profiler(profiler), _timer(timer), _start(g_system->getMillis()) {}
+	~ProfileScope() { _profiler->addTime(_timer, g_system->getMillis() - _start); }
+
+private:
+	Profiler *_profiler;
+	ProfileTimer _timer;
+	uint32 _start;
+};
+
+#define ACK_PROFILE(timer) ProfileScope profileScope_(_profiler, timer)
+
+} // End of namespace Ack
+
+#endif // ACK_PROFILER_H
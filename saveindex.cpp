@@ -0,0 +1,162 @@
+/* ScummVM - ACK Engine Save Index
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/saveindex.h"
+
+#include "common/savefile.h"
+#include "common/system.h"
+
+namespace Ack {
+
+static const uint32 kSaveIndexTag = MKTAG('A', 'C', 'K', 'I');
+static const uint16 kSaveIndexVersion = 4;
+
+SaveIndex::SaveIndex(const Common::String &target)
+	: _fileName(target + ".idx") {
+}
+
+int SaveIndex::getSlot(const Common::String &fileName) {
+	if (fileName.size() < 3 || fileName[fileName.size() - 3] != '.')
+		return -1;
+	int slot = atoi(fileName.c_str() + fileName.size() - 2);
+	return (slot >= 0 && slot <= 99) ? slot : -1;
+}
+
+bool SaveIndex::load() {
+	_entries.clear();
+
+	Common::InSaveFile *in = g_system->getSaveFileManager()->openForLoading(_fileName);
+	if (!in)
+		return false;
+
+	bool ok = in->readUint32BE() == kSaveIndexTag && in->readUint16LE() == kSaveIndexVersion;
+	uint16 count = ok ? in->readUint16LE() : 0;
+	for (uint16 i = 0; i < count && ok; i++) {
+		SaveIndexEntry entry;
+		entry.slot = in->readByte();
+		entry.description = in->readString();
+		entry.day = in->readSint16LE();
+		entry.month = in->readSint16LE();
+		entry.year = in->readSint16LE();
+		entry.hour = in->readSint16LE();
+		entry.minutes = in->readSint16LE();
+		entry.playTime = in->readUint32LE();
+		ok = !in->err() && !in->eos();
+		_entries.push_back(entry);
+	}
+	delete in;
+
+	if (!ok)
+		_entries.clear();
+	return ok;
+}
+
+bool SaveIndex::save() const {
+	Common::OutSaveFile *out = g_system->getSaveFileManager()->openForSaving(_fileName, false);
+	if (!out)
+		return false;
+
+	out->writeUint32BE(kSaveIndexTag);
+	out->writeUint16LE(kSaveIndexVersion);
+	out->writeUint16LE(_entries.size());
+	for (uint i = 0; i < _entries.size(); i++) {
+		const SaveIndexEntry &entry = _entries[i];
+		out->writeByte(entry.slot);
+		out->writeString(entry.description);
+		out->writeByte(0);
+		out->writeSint16LE(entry.day);
+		out->writeSint16LE(entry.month);
+		out->writeSint16LE(entry.year);
+		out->writeSint16LE(entry.hour);
+		out->writeSint16LE(entry.minutes);
+		out->writeUint32LE(entry.playTime);
+	}
+
+	out->finalize();
+	bool ok = !out->err();
+	delete out;
+	return ok;
+}
+
+bool SaveIndex::matches(const Common::StringArray &saveFiles) const {
+	// Listing is the one cheap query on cloud-synced save folders, so a
+	// slot set that differs from the index is the only staleness checked:
+	// saves were added or removed behind its back. Saves rewritten in place
+	// keep the index current through saveGameState(); one rewritten by a
+	// build that does not keep the index goes unnoticed until its slot set
+	// changes.
+	uint found = 0;
+	for (Common::StringArray::const_iterator file = saveFiles.begin(); file != saveFiles.end(); ++file) {
+		int slot = getSlot(*file);
+		if (slot < 0)
+			continue;
+
+		bool listed = false;
+		for (uint i = 0; i < _entries.size() && !listed; i++)
+			listed = _entries[i].slot == slot;
+		if (!listed)
+			return false;
+		found++;
+	}
+	return found == _entries.size();
+}
+
+void SaveIndex::rebuild(const Common::StringArray &saveFiles) {
+	Common::SaveFileManager *saveFileMan = g_system->getSaveFileManager();
+	_entries.clear();
+
+	for (Common::StringArray::const_iterator file = saveFiles.begin(); file != saveFiles.end(); ++file) {
+		int slot = getSlot(*file);
+		if (slot < 0)
+			continue;
+
+		Common::InSaveFile *in = saveFileMan->openForLoading(*file);
+		if (!in)
+			continue;
+
+		// Only the fixed part of the header is needed; the thumbnail that
+		// follows it is left unread.
+		SaveIndexEntry entry;
+		entry.slot = slot;
+		entry.description = in->readString();
+		entry.day = in->readSint16LE();
+		entry.month = in->readSint16LE();
+		entry.year = in->readSint16LE();
+		entry.hour = in->readSint16LE();
+		entry.minutes = in->readSint16LE();
+		entry.playTime = in->readUint32LE();
+		delete in;
+
+		update(entry);
+	}
+}
+
+void SaveIndex::refresh(const Common::StringArray &saveFiles) {
+	if (!load() || !matches(saveFiles)) {
+		rebuild(saveFiles);
+		save();
+	}
+}
+
+void SaveIndex::update(const SaveIndexEntry &entry) {
+	for (uint i = 0; i < _entries.size(); i++) {
+		if (_entries[i].slot == entry.slot) {
+			_entries[i] = entry;
+			return;
+		}
+	}
+	_entries.push_back(entry);
+}
+
+void SaveIndex::remove(int slot) {
+	for (uint i = 0; i < _entries.size(); i++) {
+		if (_entries[i].slot == slot) {
+			_entries.remove_at(i);
+			return;
+		}
+	}
+}
+
+} // End of namespace Ack
@@ -0,0 +1,61 @@
+/* ScummVM - ACK Engine Save Index
+ *
+ * A small per-target file listing every save slot with its description,
+ * date and play time, so save lists can be built without opening each save.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_SAVEINDEX_H
+#define ACK_SAVEINDEX_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/str.h"
+#include "common/str-array.h"
+
+namespace Ack {
+
+struct SaveIndexEntry {
+	int slot;
+	Common::String description;
+	int16 day, month, year;
+	int16 hour, minutes;
+	uint32 playTime;
+};
+
+class SaveIndex {
+public:
+	explicit SaveIndex(const Common::String &target);
+
+	// Reads the index; returns false if it is missing or unreadable.
+	bool load();
+	bool save() const;
+
+	// Whether the index lists exactly the slots of these save files. Only
+	// the names are compared, so no save is opened.
+	bool matches(const Common::StringArray &saveFiles) const;
+
+	// Rebuilds the index from the headers of the given save files.
+	void rebuild(const Common::StringArray &saveFiles);
+
+	// Loads the index, rebuilding and rewriting it when it is missing or no
+	// longer lists exactly these save files.
+	void refresh(const Common::StringArray &saveFiles);
+
+	void update(const SaveIndexEntry &entry);
+	void remove(int slot);
+
+	const Common::Array<SaveIndexEntry> &getEntries() const { return _entries; }
+
+	// Slot number of a "<target>.NN" save file name, or -1.
+	static int getSlot(const Common::String &fileName);
+
+private:
+	Common::String _fileName;
+	Common::Array<SaveIndexEntry> _entries;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_SAVEINDEX_H
@@ -0,0 +1,158 @@
+/* ScummVM - ACK Engine Snapshots
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/snapshot.h"
+
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Ack {
+
+static const uint32 kSnapshotTag = MKTAG('A', 'C', 'K', 'S');
+static const uint16 kSnapshotVersion = 1;
+
+enum {
+	kSnapshotFull = 0,
+	kSnapshotDelta = 1
+};
+
+SnapshotStore::SnapshotStore(const Common::String &target)
+	: _baseName(target + ".base"), _baseChecksum(0), _baseLoaded(false) {
+}
+
+uint32 SnapshotStore::checksum(const Common::Array<byte> &data) {
+	// FNV-1a; it only has to tell base images apart.
+	uint32 hash = 2166136261U;
+	for (uint i = 0; i < data.size(); i++)
+		hash = (hash ^ data[i]) * 16777619U;
+	return hash;
+}
+
+bool SnapshotStore::loadBase() {
+	if (_baseLoaded)
+		return true;
+
+	Common::InSaveFile *in = g_system->getSaveFileManager()->openForLoading(_baseName);
+	if (!in)
+		return false;
+
+	_base.resize(in->size());
+	bool ok = !_base.size() || in->read(&_base[0], _base.size()) == _base.size();
+	delete in;
+	if (!ok) {
+		_base.clear();
+		return false;
+	}
+
+	_baseChecksum = checksum(_base);
+	_baseLoaded = true;
+	return true;
+}
+
+bool SnapshotStore::saveBase(const Common::Array<byte> &state) {
+	Common::OutSaveFile *out = g_system->getSaveFileManager()->openForSaving(_baseName, false);
+	if (!out)
+		return false;
+	if (state.size())
+		out->write(&state[0], state.size());
+	out->finalize();
+	bool ok = !out->err();
+	delete out;
+
+	if (ok) {
+		_base = state;
+		_baseChecksum = checksum(_base);
+		_baseLoaded = true;
+	}
+	return ok;
+}
+
+bool SnapshotStore::write(Common::WriteStream &out, const Common::Array<byte> &state, bool delta) {
+	_buffer.resize(4 + 2 + 1 + 4);
+	WRITE_BE_UINT32(&_buffer[0], kSnapshotTag);
+	WRITE_LE_UINT16(&_buffer[4], kSnapshotVersion);
+	WRITE_LE_UINT32(&_buffer[7], state.size());
+
+	if (delta && (!loadBase() || _base.size() != state.size())) {
+		// The state changed shape; start a new base rather than diff it.
+		delta = saveBase(state);
+	}
+
+	if (delta) {
+		uint32 blocks = (state.size() + kBlockSize - 1) / kBlockSize;
+		Common::Array<uint32> changed;
+		for (uint32 b = 0; b < blocks; b++) {
+			uint32 start = b * kBlockSize;
+			uint32 size = MIN<uint32>(kBlockSize, state.size() - start);
+			if (memcmp(&state[start], &_base[start], size))
+				changed.push_back(b);
+		}
+
+		// Past half the image, a fresh base makes later deltas small again.
+		if (changed.size() * 2 > blocks && saveBase(state))
+			changed.clear();
+
+		_buffer[6] = kSnapshotDelta;
+		uint32 pos = _buffer.size();
+		_buffer.resize(pos + 8);
+		WRITE_LE_UINT32(&_buffer[pos], _baseChecksum);
+		WRITE_LE_UINT32(&_buffer[pos + 4], changed.size());
+		for (uint i = 0; i < changed.size(); i++) {
+			uint32 start = changed[i] * kBlockSize;
+			uint32 size = MIN<uint32>(kBlockSize, state.size() - start);
+			pos = _buffer.size();
+			_buffer.resize(pos + 4 + size);
+			WRITE_LE_UINT32(&_buffer[pos], changed[i]);
+			memcpy(&_buffer[pos + 4], &state[start], size);
+		}
+	} else {
+		_buffer[6] = kSnapshotFull;
+		uint32 pos = _buffer.size();
+		_buffer.resize(pos + state.size());
+		if (state.size())
+			memcpy(&_buffer[pos], &state[0], state.size());
+	}
+
+	return out.write(&_buffer[0], _buffer.size()) == _buffer.size() && !out.err();
+}
+
+bool SnapshotStore::read(Common::SeekableReadStream &in, Common::Array<byte> &state) {
+	if (in.readUint32BE() != kSnapshotTag || in.readUint16LE() != kSnapshotVersion)
+		return false;
+	byte kind = in.readByte();
+	uint32 size = in.readUint32LE();
+	if (in.err() || in.eos())
+		return false;
+
+	if (kind == kSnapshotFull) {
+		if (size > (uint32)(in.size() - in.pos()))
+			return false;
+		state.resize(size);
+		return !size || in.read(&state[0], size) == size;
+	}
+	if (kind != kSnapshotDelta)
+		return false;
+
+	uint32 baseChecksum = in.readUint32LE();
+	uint32 count = in.readUint32LE();
+	if (!loadBase() || _base.size() != size || _baseChecksum != baseChecksum) {
+		warning("Autosave refers to a base snapshot that is missing or was replaced");
+		return false;
+	}
+
+	state = _base;
+	for (uint32 i = 0; i < count; i++) {
+		uint32 start = in.readUint32LE() * kBlockSize;
+		if (in.err() || in.eos() || start >= size)
+			return false;
+		uint32 blockSize = MIN<uint32>(kBlockSize, size - start);
+		if (in.read(&state[start], blockSize) != blockSize)
+			return false;
+	}
+	return true;
+}
+
+} // End of namespace Ack
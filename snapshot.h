@@ -0,0 +1,49 @@
+/* ScummVM - ACK Engine Snapshots
+ *
+ * Save game payloads. The engine flattens its state into one byte image;
+ * a save holds either that image whole or, for autosaves, only the blocks
+ * that differ from a per-target base image kept beside the saves.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_SNAPSHOT_H
+#define ACK_SNAPSHOT_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/stream.h"
+#include "common/str.h"
+
+namespace Ack {
+
+class SnapshotStore {
+public:
+	explicit SnapshotStore(const Common::String &target);
+
+	// Writes state to out in one write. A delta is written against the base
+	// image, which is replaced by state first when too much has changed.
+	bool write(Common::WriteStream &out, const Common::Array<byte> &state, bool delta);
+
+	// Reads a payload written by write(), resolving deltas against the base.
+	bool read(Common::SeekableReadStream &in, Common::Array<byte> &state);
+
+private:
+	static const uint32 kBlockSize = 256;
+
+	bool loadBase();
+	bool saveBase(const Common::Array<byte> &state);
+	static uint32 checksum(const Common::Array<byte> &data);
+
+	Common::String _baseName;
+	Common::Array<byte> _base;
+	uint32 _baseChecksum;
+	bool _baseLoaded;
+
+	// The payload under construction, reused between saves.
+	Common::Array<byte> _buffer;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_SNAPSHOT_H
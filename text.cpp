@@ -0,0 +1,92 @@
+/* ScummVM - ACK Engine Text Renderer
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/text.h"
+#include "engines/ack/blit.h"
+
+namespace Ack {
+
+TextRenderer::TextRenderer() : _hasFont(false) {
+	memset(_atlas, 0, sizeof(_atlas));
+}
+
+void TextRenderer::setFont(const byte *fontData) {
+	_layouts.clear();
+	_hasFont = fontData != nullptr;
+	if (!_hasFont)
+		return;
+
+	for (int c = 0; c < 256; c++) {
+		for (int row = 0; row < kGlyphHeight; row++) {
+			byte bits = fontData[c * kGlyphHeight + row];
+			for (int col = 0; col < kGlyphWidth; col++)
+				_atlas[c][row][col] = (bits >> (7 - col)) & 1;
+		}
+	}
+}
+
+const TextRenderer::Layout &TextRenderer::getLayout(const Common::String &text, byte color) {
+	LayoutKey key;
+	key.text = text;
+	key.color = color;
+
+	LayoutCache::iterator it = _layouts.find(key);
+	if (it != _layouts.end())
+		return it->_value;
+
+	Layout &layout = _layouts[key];
+	layout.width = text.size() * kGlyphWidth;
+	layout.key = color ^ 1;
+	layout.pixels.resize(layout.width * kGlyphHeight);
+
+	for (uint i = 0; i < text.size(); i++) {
+		const byte (*glyph)[kGlyphWidth] = _atlas[(byte)text[i]];
+		for (int row = 0; row < kGlyphHeight; row++) {
+			byte *out = &layout.pixels[row * layout.width + i * kGlyphWidth];
+			for (int col = 0; col < kGlyphWidth; col++)
+				out[col] = glyph[row][col] ? color : layout.key;
+		}
+	}
+
+	return layout;
+}
+
+Common::Rect TextRenderer::drawText(byte *dst, int pitch, int w, int h, int x, int y, byte color,
+                                    const Common::String &text, bool cacheLayout) {
+	if (!_hasFont || text.empty())
+		return Common::Rect();
+
+	if (!cacheLayout) {
+		Common::Rect area(x, y, x + text.size() * kGlyphWidth, y + kGlyphHeight);
+		area.clip(w, h);
+		for (int py = area.top; py < area.bottom; py++) {
+			for (int px = area.left; px < area.right; px++) {
+				int i = (px - x) / kGlyphWidth;
+				if (_atlas[(byte)text[i]][py - y][(px - x) % kGlyphWidth])
+					dst[py * pitch + px] = color;
+			}
+		}
+		return area;
+	}
+
+	const Layout &layout = getLayout(text, color);
+	Common::Rect area(x, y, x + layout.width, y + kGlyphHeight);
+	area.clip(w, h);
+	if (area.isEmpty())
+		return area;
+
+	const byte *src = &layout.pixels[(area.top - y) * layout.width + (area.left - x)];
+	byte *out = dst + area.top * pitch + area.left;
+	if (area.width() == layout.width && area.height() == kGlyphHeight) {
+		// Unclipped, the layout is a row of whole glyph cells.
+		for (int i = 0; i < layout.width; i += kGlyphWidth)
+			blitFixed<kGlyphWidth, kGlyphHeight, kBlitKeyed>(out + i, pitch, src + i, layout.width, layout.key);
+	} else {
+		blitKeyed(out, pitch, src, layout.width, area.width(), area.height(), layout.key);
+	}
+	return area;
+}
+
+} // End of namespace Ack
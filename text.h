@@ -0,0 +1,73 @@
+/* ScummVM - ACK Engine Text Renderer
+ *
+ * Draws text in the 8x8 ACK font from a pre-rasterized glyph atlas, and
+ * keeps the rendered form of every string so labels redraw as row copies.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_TEXT_H
+#define ACK_TEXT_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/rect.h"
+#include "common/str.h"
+
+namespace Ack {
+
+static const int kGlyphWidth = 8;
+static const int kGlyphHeight = 8;
+
+class TextRenderer {
+public:
+	TextRenderer();
+
+	// Builds the glyph atlas from a 256-glyph 1bpp font, eight bytes per
+	// glyph with the leftmost pixel in the top bit. Drops all cached layouts.
+	void setFont(const byte *fontData);
+	bool hasFont() const { return _hasFont; }
+
+	// Draws text with its top-left corner at (x, y) into a w x h buffer,
+	// clipped to it. Returns the area written. Text that changes every frame
+	// should not be cached, or the layout cache grows without bound.
+	Common::Rect drawText(byte *dst, int pitch, int w, int h, int x, int y, byte color,
+	                      const Common::String &text, bool cacheLayout = true);
+
+private:
+	struct LayoutKey {
+		Common::String text;
+		byte color;
+
+		bool operator==(const LayoutKey &other) const {
+			return color == other.color && text == other.text;
+		}
+	};
+
+	struct LayoutKeyHash {
+		uint operator()(const LayoutKey &key) const {
+			return Common::hashit(key.text.c_str()) ^ key.color;
+		}
+	};
+
+	// A rendered string: text pixels in its color, everything else the key.
+	struct Layout {
+		int width;
+		byte key;
+		Common::Array<byte> pixels;
+	};
+
+	typedef Common::HashMap<LayoutKey, Layout, LayoutKeyHash> LayoutCache;
+
+	const Layout &getLayout(const Common::String &text, byte color);
+
+	bool _hasFont;
+	byte _atlas[256][kGlyphHeight][kGlyphWidth];
+	LayoutCache _layouts;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_TEXT_H
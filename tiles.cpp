@@ -0,0 +1,92 @@
+/* ScummVM - ACK Engine Tiles
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#include "engines/ack/tiles.h"
+#include "engines/ack/arena.h"
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Ack {
+
+void Tile::decode(const Grap256Unit &rec) {
+	for (int i = 0; i < kTileSize; i++)
+		memcpy(pixels[i], &rec.data[i + 1][1], kTileSize);
+}
+
+void Tile::encode(Grap256Unit &rec) const {
+	memset(&rec, 0, sizeof(Grap256Unit));
+	for (int i = 0; i < kTileSize; i++)
+		memcpy(&rec.data[i + 1][1], pixels[i], kTileSize);
+}
+
+TileStore::TileStore() : _tiles(nullptr), _count(0), _arena(nullptr) {
+	updateSlots();
+}
+
+void TileStore::resize(uint count) {
+	_heapTiles.clear();
+	_tiles = _arena ? _arena->allocate<Tile>(count) : nullptr;
+	if (!_tiles && count) {
+		if (_arena)
+			warning("Adventure arena is full, keeping %d tiles on the heap", count);
+		_heapTiles.resize(count);
+		memset(&_heapTiles[0], 0, count * sizeof(Tile));
+		_tiles = &_heapTiles[0];
+	}
+	_count = count;
+	updateSlots();
+}
+
+void TileStore::setArena(Arena *arena) {
+	_arena = arena;
+	_heapTiles.clear();
+	_tiles = nullptr;
+	_count = 0;
+	updateSlots();
+}
+
+void TileStore::alias(uint slot, Tile *tile) {
+	assert(slot != 0);
+	for (uint i = 0; i < _aliases.size(); i++) {
+		if (_aliases[i].slot == slot) {
+			_aliases[i].tile = tile;
+			updateSlots();
+			return;
+		}
+	}
+
+	Alias a;
+	a.slot = slot;
+	a.tile = tile;
+	_aliases.push_back(a);
+	updateSlots();
+}
+
+void TileStore::clear() {
+	_heapTiles.clear();
+	_tiles = nullptr;
+	_count = 0;
+	_aliases.clear();
+	updateSlots();
+}
+
+void TileStore::updateSlots() {
+	uint last = _count;
+	for (uint i = 0; i < _aliases.size(); i++)
+		last = MAX(last, _aliases[i].slot);
+
+	// Aliases only fill slots the adventure's own tiles do not cover.
+	_slots.resize(last + 1);
+	_slots[0] = nullptr;
+	for (uint i = 1; i <= last; i++)
+		_slots[i] = (i <= _count) ? &_tiles[i - 1] : nullptr;
+	for (uint i = 0; i < _aliases.size(); i++) {
+		if (_aliases[i].slot > _count)
+			_slots[_aliases[i].slot] = _aliases[i].tile;
+	}
+}
+
+} // End of namespace Ack
@@ -0,0 +1,95 @@
+/* ScummVM - ACK Engine Tiles
+ *
+ * In-memory and on-disk forms of the 16x16 graphic tiles, and the growable
+ * store holding an adventure's graphic tiles.
+ *
+ * Distributed under the terms of the GNU General Public License.
+ */
+
+#ifndef ACK_TILES_H
+#define ACK_TILES_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+
+namespace Ack {
+
+class Arena;
+
+// Width and height of a graphic tile, in pixels.
+static const int kTileSize = 16;
+
+// Number of tiles in an icon file.
+static const int kIconSetSize = 100;
+
+// 16x16 graphic tile record as stored in icon and graphic files (converted
+// from the Pascal type, which keeps row and column 0 unused).
+struct Grap256Unit {
+	byte data[17][17];
+};
+
+// 16x16 graphic tile as held in memory: packed and 0-based, so every row is
+// one 16-byte run. Arena storage keeps rows on 16-byte boundaries but heap
+// storage need not, so kernels must not rely on it.
+struct alignas(16) Tile {
+	byte pixels[kTileSize][kTileSize];
+
+	void decode(const Grap256Unit &rec);
+	void encode(Grap256Unit &rec) const;
+};
+
+// Graphic tiles by 1-based slot number. The store owns one contiguous run of
+// tiles sized to the adventure; further slots may alias tiles owned
+// elsewhere, such as the system icons, without copying them.
+class TileStore {
+public:
+	TileStore();
+
+	// Owns exactly slots 1..count, zero-filled. Aliases are kept.
+	void resize(uint count);
+	uint size() const { return _count; }
+
+	// Takes the tiles of later resize() calls from arena rather than the
+	// heap, falling back to the heap if it is full. The current tiles are
+	// dropped, since they may live in an arena about to be reset.
+	void setArena(Arena *arena);
+
+	// Makes slot refer to tile for as long as the store does not own it.
+	void alias(uint slot, Tile *tile);
+
+	void clear();
+
+	// Highest addressable slot, owned or aliased.
+	uint lastSlot() const { return _slots.size() - 1; }
+
+	// Whether slot refers to a tile; there may be gaps below lastSlot().
+	bool contains(uint slot) const { return slot < _slots.size() && _slots[slot]; }
+
+	Tile &operator[](uint slot) {
+		assert(slot < _slots.size() && _slots[slot]);
+		return *_slots[slot];
+	}
+	const Tile &operator[](uint slot) const {
+		assert(slot < _slots.size() && _slots[slot]);
+		return *_slots[slot];
+	}
+
+private:
+	struct Alias {
+		uint slot;
+		Tile *tile;
+	};
+
+	void updateSlots();
+
+	Tile *_tiles;
+	uint _count;
+	Arena *_arena;
+	Common::Array<Tile> _heapTiles;
+	Common::Array<Alias> _aliases;
+	Common::Array<Tile *> _slots;
+};
+
+} // End of namespace Ack
+
+#endif // ACK_TILES_H